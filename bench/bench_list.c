@@ -0,0 +1,304 @@
+#include "common.h"
+#include "list.h"
+#include "typedlist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// This benchmark compares the generic 'list_t' against the lists generated by 'DEFINE_LIST', for int and string items.
+// Usage: ./bench_list [n_items]
+
+// This is the number of items that are searched for with 'contains' in each run.
+#define N_LOOKUPS 8
+
+// This is how many times each version is run, alternating between them. The fastest time of each operation is kept,
+// since a single run of 'addlast' or 'destroy' mostly times 'malloc' and page faults, and varies by 20% or more.
+#define N_REPEATS 5
+
+// Generate the type-specialized lists used by the benchmark.
+DEFINE_LIST(intlist, int, (a > b) - (a < b))
+DEFINE_LIST(strlist, const char *, strcmp(a, b))
+
+// This is a function to get the current time in seconds.
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// This is a struct for the time each operation took, in seconds.
+typedef struct timings {
+    double add;
+    double sort;
+    double contains;
+    double iterate;
+    double destroy;
+} timings_t;
+
+// This is a function to print the timings of the generic and the typed list next to each other.
+static void print_timings(const char *what, timings_t *generic, timings_t *typed) {
+    printf("--- %s ---\n", what);
+    printf("%-10s %12s %12s %8s\n", "OP", "GENERIC(ms)", "TYPED(ms)", "SPEEDUP");
+    printf("%-10s %12.2f %12.2f %7.2fx\n", "addlast", generic->add * 1e3, typed->add * 1e3, generic->add / typed->add);
+    printf("%-10s %12.2f %12.2f %7.2fx\n", "sort", generic->sort * 1e3, typed->sort * 1e3, generic->sort / typed->sort);
+    printf("%-10s %12.2f %12.2f %7.2fx\n", "contains", generic->contains * 1e3, typed->contains * 1e3, generic->contains / typed->contains);
+    printf("%-10s %12.2f %12.2f %7.2fx\n", "iterate", generic->iterate * 1e3, typed->iterate * 1e3, generic->iterate / typed->iterate);
+    printf("%-10s %12.2f %12.2f %7.2fx\n", "destroy", generic->destroy * 1e3, typed->destroy * 1e3, generic->destroy / typed->destroy);
+    printf("\n");
+}
+
+// This is a struct for the result of one run, the checksum makes sure both lists did the same work.
+typedef struct result {
+    timings_t time;
+    long long checksum;
+} result_t;
+
+// These are the inputs shared by every run.
+static int *values;
+static char **words;
+static size_t n;
+
+// This is a function to run the generic list with int items.
+// The generic list stores pointers to the values, since it can only hold 'void *' items.
+static int run_generic_int(result_t *res) {
+    double t0 = now();
+    list_t *list = list_create((cmp_fn) intcmp);
+    for (size_t i = 0; i < n; i++) {
+        if (list_addlast(list, &values[i]) < 0) {
+            return -1;
+        }
+    }
+    double t1 = now();
+    list_sort(list);
+    double t2 = now();
+    for (size_t i = 0; i < N_LOOKUPS; i++) {
+        int needle = -(int) i;
+        res->checksum += list_contains(list, &needle);
+    }
+    double t3 = now();
+    list_iter_t *iter = list_createiter(list);
+    while (list_hasnext(iter)) {
+        res->checksum += *(int *) list_next(iter);
+    }
+    list_destroyiter(iter);
+    double t4 = now();
+    list_destroy(list, NULL);
+    double t5 = now();
+
+    res->time = (timings_t) { t1 - t0, t2 - t1, t3 - t2, t4 - t3, t5 - t4 };
+    return 0;
+}
+
+// This is a function to run the typed list with int items.
+static int run_typed_int(result_t *res) {
+    double t0 = now();
+    intlist_t *list = intlist_create();
+    for (size_t i = 0; i < n; i++) {
+        if (intlist_addlast(list, values[i]) < 0) {
+            return -1;
+        }
+    }
+    double t1 = now();
+    intlist_sort(list);
+    double t2 = now();
+    for (size_t i = 0; i < N_LOOKUPS; i++) {
+        res->checksum += intlist_contains(list, -(int) i);
+    }
+    double t3 = now();
+    intlist_iter_t *iter = intlist_createiter(list);
+    while (intlist_hasnext(iter)) {
+        res->checksum += intlist_next(iter);
+    }
+    intlist_destroyiter(iter);
+    double t4 = now();
+    intlist_destroy(list, NULL);
+    double t5 = now();
+
+    res->time = (timings_t) { t1 - t0, t2 - t1, t3 - t2, t4 - t3, t5 - t4 };
+    return 0;
+}
+
+// This is a function to run the generic list with string items.
+static int run_generic_str(result_t *res) {
+    double t0 = now();
+    list_t *list = list_create((cmp_fn) strcmp);
+    for (size_t i = 0; i < n; i++) {
+        if (list_addlast(list, words[i]) < 0) {
+            return -1;
+        }
+    }
+    double t1 = now();
+    list_sort(list);
+    double t2 = now();
+    for (size_t i = 0; i < N_LOOKUPS; i++) {
+        res->checksum += list_contains(list, "#missing");
+    }
+    double t3 = now();
+    list_iter_t *iter = list_createiter(list);
+    while (list_hasnext(iter)) {
+        res->checksum += ((char *) list_next(iter))[0];
+    }
+    list_destroyiter(iter);
+    double t4 = now();
+    list_destroy(list, NULL);
+    double t5 = now();
+
+    res->time = (timings_t) { t1 - t0, t2 - t1, t3 - t2, t4 - t3, t5 - t4 };
+    return 0;
+}
+
+// This is a function to run the typed list with string items.
+static int run_typed_str(result_t *res) {
+    double t0 = now();
+    strlist_t *list = strlist_create();
+    for (size_t i = 0; i < n; i++) {
+        if (strlist_addlast(list, words[i]) < 0) {
+            return -1;
+        }
+    }
+    double t1 = now();
+    strlist_sort(list);
+    double t2 = now();
+    for (size_t i = 0; i < N_LOOKUPS; i++) {
+        res->checksum += strlist_contains(list, "#missing");
+    }
+    double t3 = now();
+    strlist_iter_t *iter = strlist_createiter(list);
+    while (strlist_hasnext(iter)) {
+        res->checksum += strlist_next(iter)[0];
+    }
+    strlist_destroyiter(iter);
+    double t4 = now();
+    strlist_destroy(list, NULL);
+    double t5 = now();
+
+    res->time = (timings_t) { t1 - t0, t2 - t1, t3 - t2, t4 - t3, t5 - t4 };
+    return 0;
+}
+
+// This is a function to run one benchmark in a child process.
+// Every run starts with a fresh heap, otherwise the run that goes second gets its nodes from the
+// shuffled free lists left by the first one, and loses to cache misses instead of to the comparisons.
+static int run_isolated(int (*run)(result_t *), result_t *res) {
+    int fds[2];
+    if (pipe(fds) < 0) {
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        result_t child = {0};
+        int rc = run(&child);
+        close(fds[0]);
+        if (rc == 0 && write(fds[1], &child, sizeof(child)) == sizeof(child)) {
+            _exit(0);
+        }
+        _exit(1);
+    }
+
+    close(fds[1]);
+    ssize_t nread = read(fds[0], res, sizeof(*res));
+    close(fds[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+
+    if (nread != sizeof(*res) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// This is a function to keep the fastest time of each operation inside 'best'.
+static void keep_fastest(timings_t *best, const timings_t *time) {
+    best->add = time->add < best->add ? time->add : best->add;
+    best->sort = time->sort < best->sort ? time->sort : best->sort;
+    best->contains = time->contains < best->contains ? time->contains : best->contains;
+    best->iterate = time->iterate < best->iterate ? time->iterate : best->iterate;
+    best->destroy = time->destroy < best->destroy ? time->destroy : best->destroy;
+}
+
+// This is a function to run the generic and the typed version of one benchmark, and print them next to each other.
+static int bench(const char *what, int (*generic)(result_t *), int (*typed)(result_t *)) {
+    timings_t g_best, t_best;
+
+    for (size_t i = 0; i < N_REPEATS; i++) {
+        result_t g, t;
+
+        if (run_isolated(generic, &g) < 0 || run_isolated(typed, &t) < 0) {
+            printf("Error: A benchmark run for the %s failed. \n", what);
+            return -1;
+        }
+
+        if (g.checksum != t.checksum) {
+            printf("Error: The generic and the typed lists disagree for the %s. \n", what);
+            return -1;
+        }
+
+        if (i == 0) {
+            g_best = g.time;
+            t_best = t.time;
+        }
+        else {
+            keep_fastest(&g_best, &g.time);
+            keep_fastest(&t_best, &t.time);
+        }
+    }
+
+    print_timings(what, &g_best, &t_best);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+
+    n = 1000000;
+    if (argc > 1) {
+        n = strtoul(argv[1], NULL, 10);
+    }
+
+    values = malloc(n * sizeof(int));
+    words = malloc(n * sizeof(char *));
+    char *pool = malloc(n * 8);
+
+    if (values == NULL || words == NULL || pool == NULL) {
+        printf("Error: Failed to allocate memory for the benchmark data. \n");
+        return EXIT_FAILURE;
+    }
+
+    // Fill the inputs with pseudo random values and 7 letter words, with a fixed seed so every run is the same.
+    uint32_t state = 0x9e3779b9;
+    for (size_t i = 0; i < n; i++) {
+        state = state * 1664525 + 1013904223;
+        values[i] = (int) (state >> 2); // Keep the values small enough for the subtraction in 'intcmp'.
+
+        words[i] = pool + i * 8;
+        for (size_t j = 0; j < 7; j++) {
+            state = state * 1664525 + 1013904223;
+            words[i][j] = 'a' + (state >> 24) % 26;
+        }
+        words[i][7] = 0;
+    }
+
+    printf("Benchmarking with %zu items and %d lookups, the fastest of %d runs.\n\n", n, N_LOOKUPS, N_REPEATS);
+
+    int rc = bench("int items", run_generic_int, run_typed_int);
+    if (rc == 0) {
+        rc = bench("string items", run_generic_str, run_typed_str);
+    }
+
+    free(values);
+    free(words);
+    free(pool);
+
+    return rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
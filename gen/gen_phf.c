@@ -0,0 +1,268 @@
+#include "phf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+// This is a generator for the minimal perfect hash tables inside 'phf.h', it is run by the Makefile when the program is built.
+// Usage: ./gen_phf <words.txt> <name> <output.c>
+// Every word of the input is put in lower case and stripped of everything but letters and digits, the same as the
+// tokenizer does to the text, and lines that start with '#' are comments. The output defines 'const phf_t <name>'.
+
+// This is how many words go into each bucket on average. More words per bucket make the table of seeds smaller,
+// but make it harder to find a seed for the largest buckets.
+#define WORDS_PER_BUCKET 4
+
+// This is the highest seed that is tried for a bucket before giving up.
+#define MAX_SEED 10000000u
+
+// This is a struct for a word of the input, and the bucket it was put in.
+typedef struct key {
+    char *word; // This is the word.
+    size_t len; // This is the length of the word.
+    size_t bucket; // This is the bucket of the word.
+} phf_key_t;
+
+// This is a function to compare two words, for sorting and removing duplicates.
+static int compare_keys(const void *a, const void *b) {
+    return strcmp(((const phf_key_t *) a)->word, ((const phf_key_t *) b)->word);
+}
+
+// These are the number of words inside each bucket, for 'compare_buckets'.
+static const size_t *bucket_sizes;
+
+// This is a function to compare two buckets by their number of words, the largest first.
+static int compare_buckets(const void *a, const void *b) {
+    size_t sa = bucket_sizes[*(const size_t *) a];
+    size_t sb = bucket_sizes[*(const size_t *) b];
+
+    if (sa != sb) {
+        return sa > sb ? -1 : 1;
+    }
+    return (*(const size_t *) a > *(const size_t *) b) - (*(const size_t *) a < *(const size_t *) b);
+}
+
+// This is a function to read and normalize every word of the input. Returns the number of distinct words, or -1.
+static long read_keys(const char *path, phf_key_t **keys) {
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "Error: Failed to open %s \n", path);
+        return -1;
+    }
+
+    size_t n = 0, cap = 256;
+    *keys = malloc(cap * sizeof(phf_key_t));
+    char line[256];
+
+    while (*keys && fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') {
+            continue;
+        }
+
+        // Keep the letters and digits in lower case, like the tokenizer.
+        size_t len = 0;
+        for (char *c = line; *c; c++) {
+            if (isalnum((unsigned char) *c)) {
+                line[len++] = (char) tolower((unsigned char) *c);
+            }
+        }
+        if (len == 0) {
+            continue;
+        }
+
+        if (n == cap) {
+            cap *= 2;
+            phf_key_t *new_keys = realloc(*keys, cap * sizeof(phf_key_t));
+            if (new_keys == NULL) {
+                break;
+            }
+            *keys = new_keys;
+        }
+
+        (*keys)[n].word = malloc(len + 1);
+        (*keys)[n].len = len;
+        if ((*keys)[n].word == NULL) {
+            break;
+        }
+        memcpy((*keys)[n].word, line, len);
+        (*keys)[n].word[len] = '\0';
+        n++;
+    }
+
+    int failed = *keys == NULL || !feof(f);
+    fclose(f);
+
+    if (failed) {
+        fprintf(stderr, "Error: Failed to read %s \n", path);
+        return -1;
+    }
+
+    // Sort the words and remove the duplicates.
+    qsort(*keys, n, sizeof(phf_key_t), compare_keys);
+
+    size_t n_unique = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (n_unique > 0 && strcmp((*keys)[n_unique - 1].word, (*keys)[i].word) == 0) {
+            free((*keys)[i].word);
+            continue;
+        }
+        (*keys)[n_unique++] = (*keys)[i];
+    }
+
+    return (long) n_unique;
+}
+
+// This is a function to write a word as a C string literal.
+static void write_literal(FILE *out, const char *word) {
+    fputc('"', out);
+    for (const char *c = word; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', out);
+        }
+        fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+int main(int argc, char **argv) {
+
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s <words.txt> <name> <output.c> \n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    phf_key_t *keys;
+    long n_read = read_keys(argv[1], &keys);
+    if (n_read < 0) {
+        return EXIT_FAILURE;
+    }
+
+    size_t n = (size_t) n_read;
+    size_t n_buckets = n / WORDS_PER_BUCKET + 1;
+
+    size_t *sizes = calloc(n_buckets, sizeof(size_t));
+    size_t *starts = calloc(n_buckets + 1, sizeof(size_t)); // This is where the words of each bucket start inside 'members'.
+    size_t *members = malloc((n ? n : 1) * sizeof(size_t)); // These are the words, grouped by bucket.
+    size_t *order = malloc(n_buckets * sizeof(size_t));
+    uint32_t *seeds = calloc(n_buckets, sizeof(uint32_t));
+    long *slots = malloc((n ? n : 1) * sizeof(long)); // This is the word inside each slot, or -1.
+    size_t *taken = malloc((n ? n : 1) * sizeof(size_t)); // These are the slots picked for the bucket that is being placed.
+
+    if (sizes == NULL || starts == NULL || members == NULL || order == NULL || seeds == NULL || slots == NULL || taken == NULL) {
+        fprintf(stderr, "Error: Failed to allocate memory. \n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        keys[i].bucket = phf_hash(0, keys[i].word, keys[i].len) % n_buckets;
+        sizes[keys[i].bucket]++;
+        slots[i] = -1;
+    }
+
+    // Group the words by bucket, so placing a bucket only looks at its own words.
+    for (size_t b = 0; b < n_buckets; b++) {
+        starts[b + 1] = starts[b] + sizes[b];
+    }
+    // ('order' is used as the next free place of each bucket until the buckets are sorted.)
+    for (size_t b = 0; b < n_buckets; b++) {
+        order[b] = starts[b];
+    }
+    for (size_t i = 0; i < n; i++) {
+        members[order[keys[i].bucket]++] = i;
+    }
+
+    // Place the largest buckets first, while most of the slots are still free.
+    for (size_t b = 0; b < n_buckets; b++) {
+        order[b] = b;
+    }
+    bucket_sizes = sizes;
+    qsort(order, n_buckets, sizeof(size_t), compare_buckets);
+
+    for (size_t i = 0; i < n_buckets && sizes[order[i]] > 0; i++) {
+        size_t bucket = order[i];
+        uint32_t seed;
+
+        // Try seeds until every word of the bucket lands on a free slot, and no two of them on the same one.
+        for (seed = 1; seed < MAX_SEED; seed++) {
+            size_t n_taken = 0;
+            int ok = 1;
+
+            for (size_t m = starts[bucket]; m < starts[bucket + 1] && ok; m++) {
+                size_t k = members[m];
+                size_t slot = phf_hash(seed, keys[k].word, keys[k].len) % n;
+                ok = slots[slot] < 0;
+
+                for (size_t t = 0; t < n_taken && ok; t++) {
+                    ok = taken[t] != slot;
+                }
+                taken[n_taken++] = slot;
+            }
+
+            if (ok) {
+                break;
+            }
+        }
+
+        if (seed == MAX_SEED) {
+            fprintf(stderr, "Error: No seed found for a bucket of %zu words. \n", sizes[bucket]);
+            return EXIT_FAILURE;
+        }
+
+        seeds[bucket] = seed;
+        for (size_t m = starts[bucket]; m < starts[bucket + 1]; m++) {
+            size_t k = members[m];
+            slots[phf_hash(seed, keys[k].word, keys[k].len) % n] = (long) k;
+        }
+    }
+
+    FILE *out = fopen(argv[3], "w");
+    if (out == NULL) {
+        fprintf(stderr, "Error: Failed to create %s \n", argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(out, "// This file is generated from %s by gen/gen_phf.c when the program is built, do not edit it.\n", argv[1]);
+    fprintf(out, "#include \"phf.h\"\n\n");
+
+    fprintf(out, "static const uint32_t seeds[%zu] = {", n_buckets);
+    for (size_t b = 0; b < n_buckets; b++) {
+        fprintf(out, "%s%u,", b % 12 ? " " : "\n    ", seeds[b]);
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "static const char *const keys[%zu] = {", n ? n : 1);
+    for (size_t s = 0; s < n; s++) {
+        fprintf(out, "%s", s % 8 ? " " : "\n    ");
+        write_literal(out, keys[slots[s]].word);
+        fputc(',', out);
+    }
+    fprintf(out, "%s\n};\n\n", n ? "" : " 0");
+
+    fprintf(out, "static const uint32_t lens[%zu] = {", n ? n : 1);
+    for (size_t s = 0; s < n; s++) {
+        fprintf(out, "%s%zu,", s % 16 ? " " : "\n    ", keys[slots[s]].len);
+    }
+    fprintf(out, "%s\n};\n\n", n ? "" : " 0");
+
+    fprintf(out, "const phf_t %s = { %zu, %zu, seeds, keys, lens };\n", argv[2], n, n_buckets);
+
+    if (fclose(out) != 0) {
+        fprintf(stderr, "Error: Failed to write %s \n", argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        free(keys[i].word);
+    }
+    free(keys);
+    free(sizes);
+    free(starts);
+    free(members);
+    free(order);
+    free(seeds);
+    free(slots);
+    free(taken);
+    return EXIT_SUCCESS;
+}
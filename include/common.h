@@ -13,6 +13,27 @@ typedef int (*cmp_fn)(const void *, const void *);
 // This is a definition for a function that will deallocate resources and free memory.
 typedef void (*free_fn)(void *);
 
+// This is a definition for a function that will return an integer sort key for an item.
+// Items are ordered by ascending key when sorted by key.
+typedef size_t (*key_fn)(const void *);
+
+// This is a struct for a pointer to an item together with its integer sort key.
+typedef struct keyed {
+    size_t key; // This is the key the item is sorted by.
+    void *ptr; // This is a pointer to the item itself. (Or a node holding it.)
+} keyed_t;
+
+// This is a definition for a function that will sort 'n' pairs by ascending key with a stable LSD radix sort.
+// The 'scratch' array must hold 'n' pairs too. The sorted pairs end up in either 'items' or 'scratch', and that one is returned.
+keyed_t *radix_sort_keyed(keyed_t *items, keyed_t *scratch, size_t n);
+
+// This will hint the CPU to start loading the memory at 'addr' into the cache before it is used. (It never faults.)
+#if defined(__GNUC__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr) ((void) (addr))
+#endif
+
 // This is a definition for a comparison function, that will compare two integers.
 int intcmp(const int *a, const int *b);
 
@@ -0,0 +1,55 @@
+#ifndef FOLLOW_H
+#define FOLLOW_H
+#include "common.h"
+#include "futil.h"
+#include "wordfreq.h"
+#include <stdlib.h>
+
+// This is the interval between two reports when none is given, and the shortest one that is accepted, in milliseconds.
+#define FOLLOW_DEFAULT_INTERVAL 2000
+#define FOLLOW_MIN_INTERVAL 100
+
+// The follow counter counts a file that keeps growing, like a log, the same way as 'tail -f' shows it.
+// The file is read from the start once, and after that only the bytes that were appended are read, from the
+// offset where the last read stopped. (inotify wakes the reader up when the file changes.) The new bytes are fed
+// to the same tokenizer, so a word that was only half written is finished by the next read.
+//
+// The counts are kept in a hash table, and the 'k' highest ranked words are kept in a min-heap that is updated
+// with each word, so a report only sorts those 'k' words instead of the whole table.
+// Counts only grow, so a word can only enter the heap by passing the lowest ranked word inside it.
+
+// This is a struct for the follow counter, and use 'follow_t' as the alias.
+typedef struct follow follow_t;
+
+// This is a definition for a function that will create a follow counter that keeps the 'k' highest ranked words.
+// Returns NULL if 'k' is 0 or memory could not be allocated.
+follow_t *follow_create(size_t k);
+
+// This is a definition for a function that will count one word. It is a 'token_fn', so it can be given to a tokenizer.
+// Returns 0, or -1 if memory could not be allocated.
+int follow_add(void *ctx, const char *word, size_t len);
+
+// This is a definition for a function that will get the highest ranked words, ranked like 'create_wordfreqs_list'.
+// At most 'k' pairs are stored in 'top', and the number stored is returned. The pairs belong to the counter.
+size_t follow_top(follow_t *follow, const word_freq_t **top);
+
+// This is a definition for a function that will get the total number of words that were counted.
+size_t follow_nwords(follow_t *follow);
+
+// This is a definition for a function that will get the number of distinct words that were counted.
+size_t follow_ndistinct(follow_t *follow);
+
+// This is a definition for a function that is called with the counter for each report. Return a negative value to stop.
+typedef int (*follow_report_fn)(void *ctx, follow_t *follow);
+
+// This is a definition for a function that will count the file at 'path' with 'tok', and keep counting what is appended.
+// The tokenizer must emit to 'follow_add' with the counter as its context.
+// 'report' is called once the file has been read, and then every 'interval_ms' milliseconds if new words were counted.
+// If the file is truncated it is read again from the start, and if it is moved or deleted (log rotation), the new
+// file at 'path' is followed once it exists. Runs until SIGINT or SIGTERM, and returns 0, or -1 if it failed.
+int follow_file(follow_t *follow, const char *path, tokenizer_t *tok, long interval_ms, follow_report_fn report, void *ctx);
+
+// This is a definition for a function that will free every word and the counter.
+void follow_destroy(follow_t *follow);
+
+#endif /* End the head file */
@@ -3,6 +3,7 @@
 #define FUTIL_H
 #include "common.h"
 #include "list.h"
+#include "reader.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
@@ -16,6 +17,51 @@ char *basename(const char *fpathlike);
 // 2. Return 0, if there is not a new line character.
 int isnewline(int c);
 
+// This is a definition for a function that is called with each token, the token is null-terminated and 'len' characters long.
+// The token is only valid during the call. Return a negative value to stop the tokenization with that value.
+typedef int (*token_fn)(void *ctx, const char *token, size_t len);
+
+// This is a definition for a function that decides if a token is kept, it is called with each token before 'emit'.
+// Return non-zero to keep the token, or zero to drop it. (For example 'wordset_exclude' inside 'wordset.h' drops stopwords.)
+typedef int (*token_filter_fn)(void *ctx, const char *token, size_t len);
+
+// This is a struct for a tokenizer that is fed the text in blocks, and use 'tokenizer_t' as the alias.
+// A token that is split between two blocks is kept inside the tokenizer until the block with its end is fed.
+typedef struct tokenizer {
+    size_t strlen_min; // Exclude tokens of a lenght that is lower than this.
+    int (*csplitfn)(int); // Split tokens on characters where this is non-zero. (See 'ftokenize'.)
+    int (*cfilterfn)(int); // Exclude characters where this is zero, if present.
+    int (*ctransformfn)(int); // Replace each character with what this returns, if present.
+    token_fn emit; // This is called with each token.
+    void *ctx; // This is passed to 'emit'.
+    token_filter_fn keep; // Only emit the tokens where this is non-zero, if present.
+    void *keep_ctx; // This is passed to 'keep'.
+    char *buffer; // This is the buffer for the token that is being read.
+    size_t bufsize; // This is the size of the buffer.
+    size_t len; // This is the length of the token inside the buffer.
+} tokenizer_t;
+
+// This is a definition for a function that will initialize a tokenizer. Returns 0, or -1 if memory could not be allocated.
+int tokenizer_init(tokenizer_t *tok, size_t strlen_min, int (*csplitfn)(int), int (*cfilterfn)(int), int (*ctransformfn)(int), token_fn emit, void *ctx);
+
+// This is a definition for a function that will set the token filter of a tokenizer, NULL to keep every token.
+void tokenizer_set_filter(tokenizer_t *tok, token_filter_fn keep, void *keep_ctx);
+
+// This is a definition for a function that will tokenize the next 'n' characters of the text.
+// Returns 0, a negative value returned by 'emit', or -1 if memory could not be allocated.
+int tokenizer_feed(tokenizer_t *tok, const char *data, size_t n);
+
+// This is a definition for a function that will end the text, so the last token is emitted too.
+int tokenizer_finish(tokenizer_t *tok);
+
+// This is a definition for a function that will free the buffer of a tokenizer.
+void tokenizer_destroy(tokenizer_t *tok);
+
+// This is a definition for a function that will feed a whole file to a tokenizer and finish it.
+// The file is read by a reader thread (see 'reader.h'), so reading overlaps with tokenizing.
+// The timing of the reads is stored in 'stats' if it is not NULL.
+int ftokenize_each(FILE *f, tokenizer_t *tok, reader_stats_t *stats);
+
 // This is a definition for a function that will tokenize text inside a given file.
 int ftokenize(
     FILE *f, // Point to the given file.
@@ -26,6 +72,13 @@ int ftokenize(
     
     // This function is called on each character if it is present,
     // The returned character is added to the token in place of the original character. Applied after filter, if present.
-    int (*ctransformfn)(int)); 
+    int (*ctransformfn)(int),
+
+    // Only add the tokens where this is non-zero, if present. It is called with 'keep_ctx' and each finished token.
+    token_filter_fn keep,
+    void *keep_ctx,
+
+    // The timing of the reads is stored here if it is not NULL.
+    reader_stats_t *stats);
     
 #endif /* End the head file */
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef ILIST_H
+#define ILIST_H
+#include "common.h"
+#include <stddef.h>
+#include <stdlib.h>
+
+// This is an intrusive doubly linked list. Instead of the list allocating a node that points to the item,
+// the caller embeds an 'ilink_t' inside its own struct, so the record and its links are a single allocation.
+//
+// Example:
+//     struct record { ilink_t link; size_t count; };
+//     ilist_foreach(link, &list) {
+//         struct record *r = ilist_entry(link, struct record, link);
+//     }
+
+// This is a struct for the links that are embedded inside the records, and use 'ilink_t' as the alias.
+typedef struct ilink ilink_t;
+
+struct ilink {
+    ilink_t *next; // This is a pointer to the link of the next record inside the list.
+    ilink_t *prev; // This is a pointer to the link of the previous record inside the list.
+};
+
+// This is a struct for the intrusive list, and use 'ilist_t' as the alias.
+// The list does not own any memory, so it can live on the stack or inside another struct.
+typedef struct ilist {
+    ilink_t *head; // This is a pointer to the link of the first record.
+    ilink_t *tail; // This is a pointer to the link of the last record.
+    size_t length; // This is how many records are inside the list.
+} ilist_t;
+
+// This will recover a pointer to the record from a pointer to the link embedded inside it.
+// 'type' is the type of the record, and 'member' is the name of the 'ilink_t' field inside it.
+#define ilist_entry(link, type, member) ((type *) ((char *) (link) - offsetof(type, member)))
+
+// This will loop over every link inside the list, from the head to the tail.
+#define ilist_foreach(link, list) \
+    for (ilink_t *link = (list)->head; link != NULL; link = link->next)
+
+// This is a definition for a comparison function on two links, see 'cmp_fn' for what it must return.
+typedef int (*ilink_cmp_fn)(const ilink_t *, const ilink_t *);
+
+// This is a definition for a function that will return the integer sort key of the record that holds a link.
+typedef size_t (*ilink_key_fn)(const ilink_t *);
+
+// This is a definition for a function that will free the record that holds a link.
+typedef void (*ilink_free_fn)(ilink_t *);
+
+// This is a definition for a function that will initialize an empty list.
+void ilist_init(ilist_t *list);
+
+// This is a definition for a function that will free every record inside the list and leave the list empty.
+void ilist_destroy(ilist_t *list, ilink_free_fn link_free);
+
+// This is a definition for a function to get the number of records inside the list.
+size_t ilist_length(ilist_t *list);
+
+// This is a definition for a function that will add a record to the start of the list. (This can not fail.)
+void ilist_addfirst(ilist_t *list, ilink_t *link);
+
+// This is a definition for a function that will add a record to the end of the list. (This can not fail.)
+void ilist_addlast(ilist_t *list, ilink_t *link);
+
+// This is a definition for a function that will move every record of 'other' to the end of the list, leaving 'other' empty.
+void ilist_concat(ilist_t *list, ilist_t *other);
+
+// This is a definition for a function to remove the first record from the list, returns NULL if the list is empty.
+ilink_t *ilist_popfirst(ilist_t *list);
+
+// This is a definition for a function to remove the last record from the list, returns NULL if the list is empty.
+ilink_t *ilist_poplast(ilist_t *list);
+
+// This is a definition for a function that will unlink a record from anywhere inside the list.
+void ilist_remove(ilist_t *list, ilink_t *link);
+
+// This is a definition for a function that will sort the entire list with mergesort, using the given comparison function.
+void ilist_sort(ilist_t *list, ilink_cmp_fn cmpfn);
+
+// This is a definition for a function that will sort the entire list by an integer key, like 'list_sort_by_key'.
+// Returns 0 on success, or -1 if memory for the sort could not be allocated (the list is then left unchanged).
+int ilist_sort_by_key(ilist_t *list, ilink_key_fn keyfn);
+
+#endif /* End the head file */
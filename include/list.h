@@ -20,9 +20,39 @@ list_t *list_create(cmp_fn cmpfn);
 // This is a definition for a function that will destroy a list and its items.
 void list_destroy(list_t *list, free_fn item_free);
 
+// This is a definition for a function that will destroy a list and its items like 'list_destroy', but long lists are
+// freed in segments on the shared thread pool, so 'item_free' must be safe to call from several threads. (Like 'free'.)
+void list_destroy_parallel(list_t *list, free_fn item_free);
+
 // This is a definition for a function to get the number of items inside the list. (Get the lenght of the list.)
 size_t list_length(list_t *list);
 
+// The bulk operations below split the list into segments once, and process the segments on the shared thread pool
+// (see 'threadpool.h'), prefetching the nodes ahead of the one being processed. Short lists, or a machine with a
+// single CPU, are processed by the calling thread alone. The callbacks must be safe to call from several threads,
+// and must not change the list.
+
+// This is a definition for a function that is called with each item by 'list_foreach'.
+// Return a negative value to stop with that value.
+typedef int (*list_foreach_fn)(void *ctx, void *item);
+
+// This is a definition for a function that will call 'fn' with every item of the list, in no particular order.
+// A segment stops at the first negative value, and the value of the first segment that stopped is returned (0 if none).
+// Items in other segments may still have been visited.
+int list_foreach(list_t *list, list_foreach_fn fn, void *ctx);
+
+// This is a definition for a function that will fold an item into an accumulator, 'acc' points to 'acc_size' bytes.
+typedef void (*list_fold_fn)(void *ctx, void *acc, void *item);
+
+// This is a definition for a function that will combine the accumulator 'other', of the items after those of 'acc', into 'acc'.
+typedef void (*list_combine_fn)(void *ctx, void *acc, void *other);
+
+// This is a definition for a function that will reduce the list into the accumulator 'acc', which must hold the initial value.
+// Each segment folds its items in list order into its own copy of the initial value, and then the copies are combined
+// into 'acc' in list order on the calling thread. The result is the same for any number of segments, as long as
+// 'combine' joins two neighbouring folds the way folding their items one after another would.
+void list_reduce(list_t *list, void *acc, size_t acc_size, list_fold_fn fold, list_combine_fn combine, void *ctx);
+
 // This is a definition for a function that will add an item to the start of the list.
 int list_addfirst(list_t *list, void *item);
 
@@ -42,6 +72,11 @@ int list_contains(list_t *list, void *item);
 // It will sort the list by using the comparison function of the list to determine the ordering of the items.
 void list_sort(list_t *list);
 
+// This is a definition for a function that will sort the entire list by an integer key.
+// It uses an LSD radix sort on the keys returned by 'keyfn' and is stable, so items with equal keys keep their order.
+// Returns 0 on success, or -1 if memory for the sort could not be allocated (the list is then left unchanged).
+int list_sort_by_key(list_t *list, key_fn keyfn);
+
 // This is a definition for a function that will create an list iterator.
 list_iter_t *list_createiter(list_t *list);
 
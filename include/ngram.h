@@ -0,0 +1,33 @@
+#ifndef NGRAM_H
+#define NGRAM_H
+#include "common.h"
+#include "ilist.h"
+#include <stdlib.h>
+
+// This is the largest number of words inside an n-gram.
+#define NGRAM_MAX 16
+
+// The n-gram counter counts every run of <n> consecutive tokens, joined by a single space. ("the quick brown")
+// It keeps a sliding window of the last <n> tokens and a rolling hash over the hashes of those tokens,
+// so moving the window by one token costs the same no matter how large <n> is. The joined string is only
+// built and stored the first time an n-gram is seen, every other occurrence is matched against the window itself.
+
+// This is a struct for the n-gram counter, and use 'ngram_t' as the alias.
+typedef struct ngram ngram_t;
+
+// This is a definition for a function that will create a counter for n-grams of 'n' words. (1 to NGRAM_MAX.)
+// Returns NULL if 'n' is out of range or memory could not be allocated.
+ngram_t *ngram_create(size_t n);
+
+// This is a definition for a function that will add the next token to the window, and count the n-gram that ends with it.
+// It is a 'token_fn', so it can be given to a tokenizer. Returns 0, or -1 if memory could not be allocated.
+int ngram_add(void *ctx, const char *token, size_t len);
+
+// This is a definition for a function that will move the counted n-grams into 'freqs', ranked like 'create_wordfreqs_list'.
+// The total number of n-grams is stored in 'n_total'. Returns 0, or -1 if memory could not be allocated.
+int ngram_finish(ngram_t *ngram, ilist_t *freqs, size_t *n_total);
+
+// This is a definition for a function that will free the counter, and every n-gram that was not moved out of it.
+void ngram_destroy(ngram_t *ngram);
+
+#endif /* End the head file */
@@ -0,0 +1,55 @@
+#ifndef OUTBUF_H
+#define OUTBUF_H
+#include "common.h"
+#include <stdlib.h>
+#include <string.h>
+
+// This is the default size of the buffer of an output buffer. (1 MiB.)
+#define OUTBUF_SIZE (1024 * 1024)
+
+// This is a buffered writer for a file descriptor, and use 'outbuf_t' as the alias.
+// The output is collected inside one large buffer and written with a single 'write' each time it fills up,
+// so writing millions of short lines costs about as many system calls as writing the same bytes in one piece.
+// Once a write fails the error is remembered, and everything after it is dropped.
+typedef struct outbuf {
+    int fd; // This is the file descriptor the output is written to.
+    char *buf; // This is the buffer.
+    size_t size; // This is the size of the buffer.
+    size_t len; // This is how many bytes inside the buffer have not been written yet.
+    int error; // This is the 'errno' of the first write that failed, or 0.
+} outbuf_t;
+
+// This is a definition for a function that will initialize an output buffer of 'size' bytes for 'fd'.
+// Returns 0, or -1 if memory could not be allocated.
+int outbuf_init(outbuf_t *out, int fd, size_t size);
+
+// This is a definition for a function that will write everything inside the buffer. Returns 0, or -1 if a write failed.
+int outbuf_flush(outbuf_t *out);
+
+// This is a definition for a function that will flush the buffer and free it. Returns 0, or -1 if any write failed.
+int outbuf_destroy(outbuf_t *out);
+
+// This is a definition for a function that will add 'n' bytes to the buffer. Returns 0, or -1 if a write failed.
+int outbuf_write(outbuf_t *out, const char *data, size_t n);
+
+// This is a definition for a function that will add 'n' copies of the character 'c' to the buffer.
+int outbuf_fill(outbuf_t *out, char c, size_t n);
+
+// This is a definition for a function that will add the decimal digits of 'value' to the buffer.
+int outbuf_putu(outbuf_t *out, size_t value);
+
+// This will add a single character to the buffer.
+static inline int outbuf_putc(outbuf_t *out, char c) {
+    if (out->len == out->size && outbuf_flush(out) < 0) {
+        return -1;
+    }
+    out->buf[out->len++] = c;
+    return 0;
+}
+
+// This will add a null-terminated string to the buffer.
+static inline int outbuf_puts(outbuf_t *out, const char *s) {
+    return outbuf_write(out, s, strlen(s));
+}
+
+#endif /* End the head file */
@@ -0,0 +1,44 @@
+#ifndef PHF_H
+#define PHF_H
+#include <stdint.h>
+#include <stdlib.h>
+
+// A minimal perfect hash table maps each of a fixed set of 'n_keys' words to its own slot from 0 to n_keys - 1,
+// so checking if a word is in the set is two hashes and one comparison, without probing. The tables are built
+// ahead of time by 'gen/gen_phf.c' (hash and displace): the words are put into buckets by 'phf_hash(0, ...)',
+// and each bucket is given a seed for which 'phf_hash(seed, ...)' sends every word of the bucket to a free slot.
+
+// This is a struct for a generated table, and use 'phf_t' as the alias.
+typedef struct phf {
+    size_t n_keys; // This is the number of words, and the number of slots.
+    size_t n_buckets; // This is the number of buckets.
+    const uint32_t *seeds; // This is the seed of each bucket.
+    const char *const *keys; // This is the word inside each slot.
+    const uint32_t *lens; // This is the length of the word inside each slot.
+} phf_t;
+
+// This will hash a word with a seed. (32 bit FNV-1a on a seeded start value, with a final mix so every bit counts for the modulo.)
+// The generator and the lookup must agree on this exactly, so it lives here and nowhere else.
+static inline uint32_t phf_hash(uint32_t seed, const char *word, size_t len) {
+    uint32_t hash = 2166136261u ^ (seed * 0x9e3779b9u);
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char) word[i];
+        hash *= 16777619u;
+    }
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// This is a definition for a function that will check if a word of the given length is inside the table.
+int phf_contains(const phf_t *phf, const char *word, size_t len);
+
+// This is the table of the stopwords inside 'data/stopwords.txt', generated when the program is built.
+extern const phf_t phf_stopwords;
+
+#endif /* End the head file */
@@ -0,0 +1,54 @@
+#ifndef PREFIXINDEX_H
+#define PREFIXINDEX_H
+#include "common.h"
+#include "ilist.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+// This is how many words share one fully stored word inside the front-coded array.
+#define PREFIXINDEX_BLOCK 16
+
+// The prefix index holds every word of a frequency list in alphabetical order, front-coded: inside each block of
+// PREFIXINDEX_BLOCK words only the first is stored whole, and the others store how many characters they share with
+// the word before them and the rest of their characters. The words with a given prefix are then a range of the
+// array, found by binary search. A segment tree over the counts stores, for each node, the word with the highest
+// count below it, so the words of a range can be listed by descending count without looking at the others.
+// The index can be saved to a file and loaded again as it is, without sorting or building anything.
+
+// This is a struct for the prefix index, and use 'prefixindex_t' as the alias.
+typedef struct prefixindex prefixindex_t;
+
+// This is a definition for a function that is called with each result of 'prefixindex_top'.
+// The word is null-terminated and only valid during the call. Return non-zero to stop.
+typedef int (*prefix_fn)(void *ctx, const char *word, size_t len, size_t count);
+
+// This is a definition for a function that will build an index of the word-frequency pairs inside 'freqs'. (In any order.)
+// 'n_total' is the total number of words that were counted, it is kept so it can be shown after loading the index.
+// Returns NULL if memory could not be allocated.
+prefixindex_t *prefixindex_build(ilist_t *freqs, size_t n_total);
+
+// This is a definition for a function that will write the index to a file. Returns 0, or -1 on failure.
+int prefixindex_save(prefixindex_t *index, const char *path);
+
+// This is a definition for a function that will read an index written by 'prefixindex_save'.
+// Returns NULL if the file could not be read or is not a valid index.
+prefixindex_t *prefixindex_load(const char *path);
+
+// This is a definition for a function that will get the number of distinct words inside the index.
+size_t prefixindex_length(prefixindex_t *index);
+
+// This is a definition for a function that will get the total number of words given to 'prefixindex_build'.
+size_t prefixindex_total(prefixindex_t *index);
+
+// This is a definition for a function that will get how many words start with the given prefix.
+size_t prefixindex_count(prefixindex_t *index, const char *prefix, size_t len);
+
+// This is a definition for a function that will call 'fn' with the words that start with the given prefix,
+// by descending count, and words with the same count in alphabetical order. It stops when 'fn' returns non-zero.
+// The index is not safe to query from several threads at once. Returns 0, or -1 if memory could not be allocated.
+int prefixindex_top(prefixindex_t *index, const char *prefix, size_t len, prefix_fn fn, void *ctx);
+
+// This is a definition for a function that will free the index.
+void prefixindex_destroy(prefixindex_t *index);
+
+#endif /* End the head file */
@@ -0,0 +1,44 @@
+#ifndef READER_H
+#define READER_H
+#include "common.h"
+#include <stdlib.h>
+#include <sys/types.h>
+
+// This is the number of buffers inside the ring, and the size of each buffer (1 MiB in hexadecimal).
+#define READER_NBUFS 4
+#define READER_BUFSIZE 0x100000
+
+// The reader reads a file on its own thread into a ring of large buffers, while the caller consumes the buffers
+// that are already filled. So the disk does not idle while the caller is working, and the caller does not idle
+// while the disk is reading. Reads use io_uring where the kernel supports it, and plain 'read()' otherwise.
+
+// This is a struct for the reader, and use 'reader_t' as the alias.
+typedef struct reader reader_t;
+
+// This is a struct for the timing of a reader, and use 'reader_stats_t' as the alias.
+typedef struct reader_stats {
+    size_t bytes; // This is how many bytes were read.
+    size_t n_buffers; // This is how many buffers were filled.
+    int uring; // This is 1 if the reads used io_uring, 0 if they used 'read()'.
+    double read_s; // This is how long the reader thread was busy reading, in seconds.
+    double wait_s; // This is how long the caller waited for a buffer to be filled, in seconds.
+    double wall_s; // This is how long it took from opening to closing the reader, in seconds.
+} reader_stats_t;
+
+// This is a definition for a function that will start reading the file 'fd' from its current offset.
+// Returns NULL if memory could not be allocated or the thread could not be started. The fd is not closed by the reader.
+reader_t *reader_open(int fd);
+
+// This is a definition for a function that will wait for the next filled buffer, and point 'buf' to it.
+// The buffer stays valid until the next call to 'reader_next' or 'reader_close'.
+// Returns the number of bytes inside the buffer, 0 at the end of the file, or -1 if reading failed.
+ssize_t reader_next(reader_t *reader, const char **buf);
+
+// This is a definition for a function that will stop the reader and free it.
+// The timing is stored in 'stats' if it is not NULL. Returns 0, or -1 if reading failed.
+int reader_close(reader_t *reader, reader_stats_t *stats);
+
+// This is a definition for a function that will print the timing of a reader, and how much reading and computing overlapped.
+void reader_print_stats(FILE *out, reader_stats_t *stats);
+
+#endif /* End the head file */
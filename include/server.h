@@ -0,0 +1,50 @@
+#ifndef SERVER_H
+#define SERVER_H
+#include "common.h"
+#include "ilist.h"
+#include <stdlib.h>
+
+// This is the longest request line a client may send, including the new line character.
+#define SERVER_MAX_LINE 1024
+
+// The server answers queries about a ranked word frequency list over a Unix domain socket.
+// Each request is one line, and each response starts with a status line:
+//
+//     TOP [k [min_wc [min_wl]]]       The k most frequent words. (0 for all.)
+//     FILTER min_wc min_wl lim        The same query as the command line arguments.
+//     GET word                        The count of a single word.
+//     PREFIX p [k [min_wc [min_wl]]]  The k most frequent words that start with p. (See 'prefixindex.h'.)
+//     STATS                           The total and the distinct number of words.
+//     QUIT                            Close the connection.
+//
+// A successful response is "OK <n>" followed by n lines of "<word>\t<count>",
+// and a failed one is a single "ERR <message>" line. Arguments that are left out use the defaults given to the server.
+
+// This is a struct for the state needed to answer queries, and use 'server_data_t' as the alias.
+typedef struct server_data {
+    ilist_t *freqs; // This is the ranked list of word-frequency pairs.
+    size_t n_words; // This is the total number of words that were counted.
+    size_t min_wc; // This is the default for <min_wc>.
+    size_t min_wl; // This is the default for <min_wl>.
+    size_t lim_nres; // This is the default for <lim_n_results>.
+} server_data_t;
+
+// This is a definition for a function that will serve queries on the socket at 'sockpath' until SIGINT or SIGTERM.
+// Returns 0 when the server was stopped by a signal, or -1 if it failed.
+int serve_wordfreqs(const char *sockpath, server_data_t *data);
+
+// This is a struct for a client connection, and use 'server_conn_t' as the alias.
+typedef struct server_conn server_conn_t;
+
+// This is a definition for a function that will connect to the server at 'sockpath', returns NULL if it failed.
+server_conn_t *server_connect(const char *sockpath);
+
+// This is a definition for a function that will close a connection to the server.
+void server_disconnect(server_conn_t *conn);
+
+// This is a definition for a function that will send one request line (without the new line character) and read the response.
+// The response lines are written to 'out' if it is not NULL.
+// Returns the number of result lines for "OK", -2 for "ERR", or -1 if the connection failed.
+long server_query(server_conn_t *conn, const char *request, FILE *out);
+
+#endif /* End the head file */
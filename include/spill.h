@@ -0,0 +1,56 @@
+#ifndef SPILL_H
+#define SPILL_H
+#include "common.h"
+#include "ilist.h"
+#include <stdlib.h>
+
+// This is the smallest memory budget that is accepted, since the reader buffers alone need 4 MiB.
+#define SPILL_MIN_MEMORY (8 * 1024 * 1024)
+
+// This is an estimate of what the program uses besides the counts and the buffers: the code, the C library and the
+// stacks of the threads. It is taken from the budget along with the reader and the output buffers.
+#define SPILL_BASE_MEMORY (2 * 1024 * 1024)
+
+// This is the most runs that are merged at once. (It is lowered to fit the limit on open files and the buffer budget.)
+#define SPILL_MAX_FAN_IN 16
+
+// The spill counter counts words within a memory budget, which is meant for the whole process (its peak RSS).
+// The buffers that are always allocated, and an estimate of the rest of the program, are taken from it first.
+// The words are counted in a hash table, and when the table would grow past the budget its counts are sorted by word
+// and written to a run file inside a temporary directory.
+// Once there are 'fan-in' runs of the same size, they are merged into one bigger run, so only a few files are open
+// at any time however large the input is. At the end every run is merged (k-way, by word) into the final counts.
+// The ranked results are kept in memory if they fit inside the budget, otherwise they are ranked on disk the same way,
+// so memory does not grow with the input or with the number of distinct words.
+
+// This is a struct for the spill counter, and use 'spill_t' as the alias.
+typedef struct spill spill_t;
+
+// This is a definition for a function that is called with each result, in ranked order. Return non-zero to stop.
+typedef int (*spill_result_fn)(void *ctx, const char *word, size_t len, size_t count);
+
+// This is a definition for a function that will create a spill counter that stays within 'max_memory' bytes,
+// and writes its run files to 'tmpdir'. Returns NULL if memory could not be allocated.
+spill_t *spill_create(size_t max_memory, const char *tmpdir);
+
+// This is a definition for a function that will count one word. It is a 'token_fn', so it can be given to a tokenizer.
+// Returns 0, or -1 if memory could not be allocated or a run file could not be written.
+int spill_add(void *ctx, const char *word, size_t len);
+
+// This is a definition for a function that will merge every run into the final counts.
+// The words that occur at least 'min_wc' times are ranked like 'create_wordfreqs_list'.
+// If 'lim_nres' is not 0, only the 'lim_nres' first of them are needed. (More may be kept, see 'spill_results'.)
+// The total and the distinct number of words are stored in 'n_words' and 'n_distinct'. Returns 0, or -1 on failure.
+int spill_finish(spill_t *spill, size_t min_wc, size_t lim_nres, size_t *n_words, size_t *n_distinct);
+
+// This is a definition for a function that will call 'result' with each result of 'spill_finish', in ranked order.
+// Returns 0, or -1 if a run file could not be read. It can only be called once.
+int spill_results(spill_t *spill, spill_result_fn result, void *ctx);
+
+// This is a definition for a function that will get how many run files were written, including the merged ones.
+size_t spill_nruns(spill_t *spill);
+
+// This is a definition for a function that will close every run file and free the spill counter.
+void spill_destroy(spill_t *spill);
+
+#endif /* End the head file */
@@ -0,0 +1,35 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include "common.h"
+#include <stdlib.h>
+
+// This is a pool of worker threads that run the tasks of one parallel loop at a time.
+// The thread calling 'threadpool_run' runs tasks too, and it returns once every task has finished.
+// A task must not call 'threadpool_run' on the same pool, since the pool only runs one loop at a time.
+
+// This is a struct for the thread pool, and use 'threadpool_t' as the alias.
+typedef struct threadpool threadpool_t;
+
+// This is a definition for a function that runs one task of a loop, 'task' is its index from 0 to n_tasks - 1.
+typedef void (*task_fn)(void *ctx, size_t task);
+
+// This is a definition for a function that will create a pool with 'n_workers' threads besides the calling thread.
+// Returns NULL if memory could not be allocated or the threads could not be started.
+threadpool_t *threadpool_create(size_t n_workers);
+
+// This is a definition for a function that will get how many threads run tasks, counting the calling thread.
+size_t threadpool_size(threadpool_t *pool);
+
+// This is a definition for a function that will run 'fn' for every task from 0 to n_tasks - 1, and wait for all of them.
+// The tasks are handed out in order, but they may run at the same time and finish in any order.
+void threadpool_run(threadpool_t *pool, size_t n_tasks, task_fn fn, void *ctx);
+
+// This is a definition for a function that will stop the threads and free the pool.
+void threadpool_destroy(threadpool_t *pool);
+
+// This is a definition for a function that will get the pool shared by the whole program, with one thread per online CPU.
+// It is created the first time it is needed. Returns NULL if there is only one CPU or the pool could not be created,
+// and the caller should then do the work itself.
+threadpool_t *threadpool_shared(void);
+
+#endif /* End the head file */
@@ -0,0 +1,256 @@
+#ifndef TYPEDLIST_H
+#define TYPEDLIST_H
+#include <stdlib.h>
+
+// This header generates a type-specialized doubly linked list with the same operations as 'list.h'.
+// The items are stored by value inside the nodes, and the comparison is inlined instead of called through a 'cmp_fn'.
+//
+// DEFINE_LIST(name, T, cmp_expr) defines:
+// 1. The types 'name_t' (the list) and 'name_iter_t' (the iterator).
+// 2. The functions 'name_create', 'name_destroy', 'name_length', 'name_addfirst', 'name_addlast',
+//    'name_popfirst', 'name_poplast', 'name_contains', 'name_sort', 'name_createiter', 'name_destroyiter',
+//    'name_hasnext', 'name_next' and 'name_resetiter'.
+//
+// The 'cmp_expr' is an expression of the two items 'a' and 'b' (both of type T), that will return:
+// 1. 0 if two items are equal,
+// 2. > 0 if (a > b),
+// 3. < 0 if (a < b).
+//
+// Since items are stored by value, 'name_popfirst' and 'name_poplast' store the removed item in '*item'
+// and return 0, or return -1 if the list is empty.
+//
+// Example: DEFINE_LIST(intlist, int, (a > b) - (a < b))
+#define DEFINE_LIST(name, T, cmp_expr) \
+\
+typedef struct name##_node name##_node_t; \
+\
+/* This is the struct for the individual nodes, the item is stored inside the node. */ \
+struct name##_node { \
+    name##_node_t *next; \
+    name##_node_t *prev; \
+    T item; \
+}; \
+\
+typedef struct name { \
+    name##_node_t *head; \
+    name##_node_t *tail; \
+    size_t length; \
+} name##_t; \
+\
+typedef struct name##_iter { \
+    name##_t *list; \
+    name##_node_t *node; \
+} name##_iter_t; \
+\
+/* This is the inlined comparison of two items. */ \
+static inline int name##_cmp(T a, T b) { \
+    return (cmp_expr); \
+} \
+\
+static inline name##_t *name##_create(void) { \
+    name##_t *list = (name##_t *) malloc(sizeof(name##_t)); \
+    if (list == NULL) { \
+        return NULL; \
+    } \
+    list->head = NULL; \
+    list->tail = NULL; \
+    list->length = 0; \
+    return list; \
+} \
+\
+/* The 'item_free' function is called on each item if it is present. */ \
+static inline void name##_destroy(name##_t *list, void (*item_free)(T)) { \
+    if (list == NULL) { \
+        return; \
+    } \
+    name##_node_t *current = list->head; \
+    while (current != NULL) { \
+        name##_node_t *temp = current; \
+        current = current->next; \
+        if (item_free) { \
+            item_free(temp->item); \
+        } \
+        free(temp); \
+    } \
+    free(list); \
+} \
+\
+static inline size_t name##_length(name##_t *list) { \
+    return list->length; \
+} \
+\
+static inline int name##_addfirst(name##_t *list, T item) { \
+    name##_node_t *node = (name##_node_t *) malloc(sizeof(name##_node_t)); \
+    if (node == NULL) { \
+        return -1; \
+    } \
+    node->item = item; \
+    node->next = list->head; \
+    node->prev = NULL; \
+    if (list->tail == NULL) { \
+        list->tail = node; \
+    } \
+    else { \
+        list->head->prev = node; \
+    } \
+    list->head = node; \
+    list->length++; \
+    return 0; \
+} \
+\
+static inline int name##_addlast(name##_t *list, T item) { \
+    name##_node_t *node = (name##_node_t *) malloc(sizeof(name##_node_t)); \
+    if (node == NULL) { \
+        return -1; \
+    } \
+    node->item = item; \
+    node->next = NULL; \
+    node->prev = list->tail; \
+    if (list->tail == NULL) { \
+        list->head = node; \
+    } \
+    else { \
+        list->tail->next = node; \
+    } \
+    list->tail = node; \
+    list->length++; \
+    return 0; \
+} \
+\
+static inline int name##_popfirst(name##_t *list, T *item) { \
+    if (list->head == NULL) { \
+        return -1; \
+    } \
+    name##_node_t *temp = list->head; \
+    *item = temp->item; \
+    list->head = temp->next; \
+    if (list->head != NULL) { \
+        list->head->prev = NULL; \
+    } \
+    else { \
+        list->tail = NULL; \
+    } \
+    free(temp); \
+    list->length--; \
+    return 0; \
+} \
+\
+static inline int name##_poplast(name##_t *list, T *item) { \
+    if (list->head == NULL) { \
+        return -1; \
+    } \
+    name##_node_t *temp = list->tail; \
+    *item = temp->item; \
+    list->tail = temp->prev; \
+    if (list->tail != NULL) { \
+        list->tail->next = NULL; \
+    } \
+    else { \
+        list->head = NULL; \
+    } \
+    free(temp); \
+    list->length--; \
+    return 0; \
+} \
+\
+static inline int name##_contains(name##_t *list, T item) { \
+    for (name##_node_t *node = list->head; node != NULL; node = node->next) { \
+        if (name##_cmp(node->item, item) == 0) { \
+            return 1; \
+        } \
+    } \
+    return 0; \
+} \
+\
+/* This is the same mergesort as in 'linkedlist.c', with the comparison inlined. */ \
+static inline name##_node_t *name##_merge(name##_node_t *a, name##_node_t *b) { \
+    name##_node_t *head, *tail; \
+    if (name##_cmp(a->item, b->item) < 0) { \
+        head = tail = a; \
+        a = a->next; \
+    } \
+    else { \
+        head = tail = b; \
+        b = b->next; \
+    } \
+    while (a && b) { \
+        if (name##_cmp(a->item, b->item) < 0) { \
+            tail->next = a; \
+            tail = a; \
+            a = a->next; \
+        } \
+        else { \
+            tail->next = b; \
+            tail = b; \
+            b = b->next; \
+        } \
+    } \
+    tail->next = a ? a : b; \
+    return head; \
+} \
+\
+static inline name##_node_t *name##_splitlist(name##_node_t *head) { \
+    name##_node_t *slow = head; \
+    name##_node_t *fast = head->next; \
+    while (fast != NULL && fast->next != NULL) { \
+        slow = slow->next; \
+        fast = fast->next->next; \
+    } \
+    name##_node_t *half = slow->next; \
+    slow->next = NULL; \
+    return half; \
+} \
+\
+static inline name##_node_t *name##_mergesort(name##_node_t *head) { \
+    if (head->next == NULL) { \
+        return head; \
+    } \
+    name##_node_t *half = name##_splitlist(head); \
+    head = name##_mergesort(head); \
+    half = name##_mergesort(half); \
+    return name##_merge(head, half); \
+} \
+\
+static inline void name##_sort(name##_t *list) { \
+    if (list->head == NULL) { \
+        return; \
+    } \
+    list->head = name##_mergesort(list->head); \
+    name##_node_t *prev = NULL; \
+    for (name##_node_t *n = list->head; n != NULL; n = n->next) { \
+        n->prev = prev; \
+        prev = n; \
+    } \
+    list->tail = prev; \
+} \
+\
+static inline name##_iter_t *name##_createiter(name##_t *list) { \
+    name##_iter_t *iter = (name##_iter_t *) malloc(sizeof(name##_iter_t)); \
+    if (iter == NULL) { \
+        return NULL; \
+    } \
+    iter->list = list; \
+    iter->node = list->head; \
+    return iter; \
+} \
+\
+static inline void name##_destroyiter(name##_iter_t *iter) { \
+    free(iter); \
+} \
+\
+static inline int name##_hasnext(name##_iter_t *iter) { \
+    return iter->node != NULL; \
+} \
+\
+/* Unlike 'list_next', there is no NULL to return at the end, so check 'name_hasnext' first. */ \
+static inline T name##_next(name##_iter_t *iter) { \
+    T item = iter->node->item; \
+    iter->node = iter->node->next; \
+    return item; \
+} \
+\
+static inline void name##_resetiter(name##_iter_t *iter) { \
+    iter->node = iter->list->head; \
+}
+
+#endif /* End the head file */
@@ -0,0 +1,107 @@
+#ifndef WORDFREQ_H
+#define WORDFREQ_H
+#include "common.h"
+#include "list.h"
+#include "ilist.h"
+#include "outbuf.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+// This is the size of the inline storage for a word, including the null-terminator.
+// Words shorter than this are stored inside the record itself, longer words are stored on the heap.
+#define WORD_FREQ_INLINE 16
+
+// This is a struct that represents a single word-frequency pair. The alias is 'word_freq_t'.
+// The pairs are kept inside an intrusive 'ilist_t', so each pair and its links are one allocation,
+// and short words are stored inline so reading the word does not need another cache miss. (48 bytes in total.)
+typedef struct word_freq {
+    ilink_t link; // These are the links to the next and previous pairs inside the list.
+    size_t count; // This is how many times that word appears.
+    uint32_t len; // This is the length of the word, without the null-terminator.
+    uint32_t hash; // This is the hash of the word, see 'word_hash'.
+    union {
+        char short_[WORD_FREQ_INLINE]; // This is the word itself, if 'len' is less than WORD_FREQ_INLINE.
+        char *long_; // This is a pointer to the word on the heap, otherwise.
+    } word;
+} word_freq_t;
+
+// This will get the null-terminated word of a 'word_freq_t'.
+static inline const char *word_freq_word(const word_freq_t *freq) {
+    return freq->len < WORD_FREQ_INLINE ? freq->word.short_ : freq->word.long_;
+}
+
+// This is a definition for a function that will hash a word of the given length. (32 bit FNV-1a.)
+uint32_t word_hash(const char *word, size_t len);
+
+// This is a definition for a function that will create a new word-frequency pair for a word of the given length.
+// Returns NULL if memory could not be allocated.
+word_freq_t *word_freq_create(const char *word, size_t len, size_t count);
+
+// This is a definition for a function that will create a word-frequency pair like 'word_freq_create', inside an
+// allocation of 'size' bytes, so a caller can keep its own fields after the pair. (A struct that starts with a 'word_freq_t'.)
+// It is freed with 'word_freq_free' like any other pair. Returns NULL if memory could not be allocated.
+word_freq_t *word_freq_create_sized(const char *word, size_t len, size_t count, size_t size);
+
+// This is a definition for a function that will check if the word of a pair is equal to the given word.
+// The cached hash and length are compared first, so most mismatches never touch the strings.
+int word_freq_equals(const word_freq_t *freq, const char *word, size_t len, uint32_t hash);
+
+// This is a definition for a function that will free a word-frequency pair, given its link.
+void word_freq_free(ilink_t *link);
+
+// This is a definition for a comparison function that will order the pairs by descending count.
+int compare_word_freq_by_count(const ilink_t *la, const ilink_t *lb);
+
+// This is a definition for a comparison function that will order the pairs alphabetically by word.
+int compare_word_freq_by_word(const ilink_t *la, const ilink_t *lb);
+
+// This is a definition for the sort key of a pair, so that sorting by ascending key ranks the highest counts first.
+size_t word_freq_count_key(const ilink_t *link);
+
+// This is a definition for a function that will fill the 'freqs' list with word-frequency pairs, counted from the sorted 'words' list.
+// The pairs are ranked by descending count, and words with the same count are in alphabetical order.
+// Returns 0 on success, or -1 on failure (the 'freqs' list is then empty).
+int create_wordfreqs_list(list_t *words, ilist_t *freqs);
+
+// This is an enum for the formats the results can be printed in, and use 'output_format_t' as the alias.
+typedef enum output_format {
+    FORMAT_TEXT, // A table for reading in a terminal, with a header. (This is the default.)
+    FORMAT_TSV, // One "word<TAB>count" line per result, after a "word<TAB>count" header line.
+    FORMAT_CSV, // One "word,count" line per result, after a "word,count" header line. Words are quoted when needed.
+    FORMAT_JSON, // One {"word":"...","count":n} object per line. (JSON lines.)
+} output_format_t;
+
+// This is a definition for a function that will get the format with the given name. ("text", "tsv", "csv" or "json".)
+// Returns 0, or -1 if there is no format with that name.
+int parse_output_format(const char *name, output_format_t *format);
+
+// This is a struct for printing ranked results one at a time, and use 'wordfreq_printer_t' as the alias.
+// It is used when the results are not all in memory at once, see 'spill_results'.
+typedef struct wordfreq_printer {
+    outbuf_t out; // This is the output buffer for stdout.
+    size_t min_wc; // The results end at the first word that occurs less times than this.
+    size_t lim_nres; // The results end after this many, or 0 for all.
+    output_format_t format; // This is the format of the results.
+    size_t n_printed; // This is how many results were printed.
+} wordfreq_printer_t;
+
+// This is a definition for a function that will print the header of the results and start the printer.
+// Returns 0, or -1 if memory could not be allocated.
+int wordfreq_printer_init(wordfreq_printer_t *printer, size_t n_distinct, size_t min_wc, size_t lim_nres, output_format_t format);
+
+// This is a definition for a function that will print the next ranked result, 'ctx' is the printer.
+// The word does not have to be null-terminated. Returns non-zero once the results are done, or the output is gone.
+int wordfreq_printer_add(void *ctx, const char *word, size_t len, size_t count);
+
+// This is a definition for a function that will write out the rest of the results. Returns 0, or -1 if writing failed.
+int wordfreq_printer_finish(wordfreq_printer_t *printer);
+
+// This is a definition for a function that will print out the word frequency list, shows the result.
+// The 'freqs' list may hold only the words that will be printed, so the number of distinct words is passed in.
+// The results are written to stdout through a large buffer (see 'outbuf.h'). Returns 0, or -1 if writing failed.
+int print_wordfreqs_list(ilist_t *freqs, size_t n_distinct, size_t min_wc, size_t lim_nres, output_format_t format);
+
+// This is a definition for a function that will print out 'n' ranked word-frequency pairs from an array, like 'print_wordfreqs_list'.
+int print_wordfreqs_array(const word_freq_t *const *freqs, size_t n, size_t n_distinct, size_t min_wc, size_t lim_nres, output_format_t format);
+
+#endif /* End the head file */
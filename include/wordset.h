@@ -0,0 +1,42 @@
+#ifndef WORDSET_H
+#define WORDSET_H
+#include "common.h"
+#include "ilist.h"
+#include "phf.h"
+#include "wordtable.h"
+#include <stdlib.h>
+
+// This is a set of words for the token filter of the tokenizer, and use 'wordset_t' as the alias.
+// A set known when the program is built is a generated perfect hash table (see 'phf.h'), which needs no memory and no
+// probing. Words that are only known when the program runs, such as a stopword file, go into a hash table instead.
+typedef struct wordset {
+    const phf_t *builtin; // This is the generated table, or NULL.
+    wordtable_t table; // This indexes the words that were loaded when the program runs.
+    ilist_t words; // These are the words that were loaded, the table points into them.
+} wordset_t;
+
+// This is a definition for a function that will initialize an empty set. Returns 0, or -1 if memory could not be allocated.
+int wordset_init(wordset_t *set);
+
+// This is a definition for a function that will add every word of a generated table to the set.
+void wordset_add_builtin(wordset_t *set, const phf_t *builtin);
+
+// This is a definition for a function that will add a single word to the set. Returns 0, or -1 if memory could not be allocated.
+int wordset_add(wordset_t *set, const char *word, size_t len);
+
+// This is a definition for a function that will add every word of a file to the set.
+// The file is tokenized the same way as the text, so the words match the tokens, and lines that start with '#' are skipped.
+// Returns 0, or -1 on failure.
+int wordset_load(wordset_t *set, const char *path);
+
+// This is a definition for a function that will check if a word is inside the set.
+int wordset_contains(wordset_t *set, const char *word, size_t len);
+
+// This is a definition for a token filter that keeps the tokens that are NOT inside the set, 'ctx' is the set.
+// (See 'tokenizer_set_filter'.)
+int wordset_exclude(void *ctx, const char *token, size_t len);
+
+// This is a definition for a function that will free the words of the set.
+void wordset_destroy(wordset_t *set);
+
+#endif /* End the head file */
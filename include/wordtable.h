@@ -0,0 +1,38 @@
+#ifndef WORDTABLE_H
+#define WORDTABLE_H
+#include "common.h"
+#include "wordfreq.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+// This is a hash table that indexes word-frequency pairs by their word, and use 'wordtable_t' as the alias.
+// It uses open addressing with linear probing on the hash that is cached inside each 'word_freq_t'.
+// The table only holds pointers, the pairs themselves are owned by whoever created them. (Usually an 'ilist_t'.)
+typedef struct wordtable {
+    word_freq_t **slots; // This is the array of slots, a NULL slot is empty.
+    size_t capacity; // This is the number of slots, always a power of two.
+    size_t length; // This is the number of pairs inside the table.
+} wordtable_t;
+
+// This is a definition for a function that will initialize an empty table with room for about 'n' pairs.
+// Returns 0 on success, or -1 if memory could not be allocated.
+int wordtable_init(wordtable_t *table, size_t n);
+
+// This is a definition for a function that will free the slots of the table. (The pairs are not freed.)
+void wordtable_destroy(wordtable_t *table);
+
+// This is a definition for a function that will find the pair for a word, returns NULL if it is not inside the table.
+word_freq_t *wordtable_find(wordtable_t *table, const char *word, size_t len, uint32_t hash);
+
+// This is a definition for a function that is called on the pairs with a matching hash, and returns non-zero if the pair is the one searched for.
+typedef int (*wordtable_match_fn)(const word_freq_t *freq, void *ctx);
+
+// This is a definition for a function that will find a pair with 'match' instead of comparing against a word,
+// for when the word being searched for is not stored as one string. Returns NULL if no pair matches.
+word_freq_t *wordtable_find_match(wordtable_t *table, uint32_t hash, wordtable_match_fn match, void *ctx);
+
+// This is a definition for a function that will add a pair to the table, the table grows when it gets too full.
+// The word must not be inside the table already. Returns 0 on success, or -1 if memory could not be allocated.
+int wordtable_insert(wordtable_t *table, word_freq_t *freq);
+
+#endif /* End the head file */
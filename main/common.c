@@ -13,6 +13,61 @@ int charcmp(const char *a, const char *b) {
     return (int) (*a - *b);
 }
 
+// The number of bits that are sorted in each radix pass, and the number of buckets needed for them.
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES ((sizeof(size_t) * 8) / RADIX_BITS)
+
+// This function will sort the pairs by their keys, one stable counting sort per digit, starting with the least significant one.
+keyed_t *radix_sort_keyed(keyed_t *items, keyed_t *scratch, size_t n) {
+
+    keyed_t *src = items;
+    keyed_t *dst = scratch;
+
+    if (n < 2) {
+        return src;
+    }
+
+    // Histogram every digit of every key in a single pass.
+    size_t counts[RADIX_PASSES][RADIX_BUCKETS] = {{0}};
+
+    for (size_t i = 0; i < n; i++) {
+        size_t key = src[i].key;
+
+        for (size_t pass = 0; pass < RADIX_PASSES; pass++) {
+            counts[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    for (size_t pass = 0; pass < RADIX_PASSES; pass++) {
+        size_t *count = counts[pass];
+        unsigned shift = pass * RADIX_BITS;
+
+        // If every key has the same digit in this pass, the pass would not change the order, so skip it.
+        if (count[(src[0].key >> shift) & (RADIX_BUCKETS - 1)] == n) {
+            continue;
+        }
+
+        // Turn the counts into the start offset of each bucket.
+        size_t offset = 0;
+        for (size_t b = 0; b < RADIX_BUCKETS; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            dst[count[(src[i].key >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+        }
+
+        keyed_t *temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    return src;
+}
+
 // This function will return the filename of the file inside the filepath.
 // For example: /home/main/file.txt = 'file.txt'.
 char *basename(const char *fpathlike) {
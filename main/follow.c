@@ -0,0 +1,430 @@
+#include "follow.h"
+#include "common.h"
+#include "futil.h"
+#include "ilist.h"
+#include "wordfreq.h"
+#include "wordtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+// This is the size of the buffer the appended bytes are read into.
+#define FOLLOW_BUFSIZE (1024 * 1024)
+
+// This is the value of 'slot' for a word that is not inside the heap.
+#define NO_SLOT SIZE_MAX
+
+// This is a struct for a counted word, and where it is inside the heap.
+typedef struct follow_word {
+    word_freq_t freq; // This is the word and its count. (It is first, so the word is freed with 'word_freq_free'.)
+    size_t slot; // This is the index of the word inside the heap, or NO_SLOT.
+} follow_word_t;
+
+// This is the struct for the follow counter.
+struct follow {
+    wordtable_t table; // This indexes the words.
+    ilist_t records; // These are the words, in the order they were first seen.
+    size_t n_words; // This is how many words have been counted.
+    word_freq_t **heap; // This is the min-heap of the 'k' highest ranked words, the lowest ranked one is first.
+    size_t heap_len; // This is how many words are inside the heap.
+    size_t k; // This is how many words the heap keeps.
+};
+
+// This is set by the signal handler when following should stop.
+static volatile sig_atomic_t stop_requested = 0;
+
+// This is the signal handler for SIGINT and SIGTERM.
+static void request_stop(int sig) {
+    (void) sig;
+    stop_requested = 1;
+}
+
+// This is a function to create a follow counter that keeps the 'k' highest ranked words.
+follow_t *follow_create(size_t k) {
+
+    if (k == 0) {
+        return NULL;
+    }
+
+    follow_t *follow = calloc(1, sizeof(follow_t));
+    if (follow == NULL) {
+        return NULL;
+    }
+
+    follow->k = k;
+    ilist_init(&follow->records);
+    follow->heap = malloc(k * sizeof(word_freq_t *));
+
+    if (follow->heap == NULL || wordtable_init(&follow->table, 0) < 0) {
+        free(follow->heap);
+        free(follow);
+        return NULL;
+    }
+
+    return follow;
+}
+
+// This is a function to check if 'a' ranks below 'b': a lower count, or the same count and a later word.
+static int ranks_below(const word_freq_t *a, const word_freq_t *b) {
+    if (a->count != b->count) {
+        return a->count < b->count;
+    }
+    return strcmp(word_freq_word(a), word_freq_word(b)) > 0;
+}
+
+// This is a function to get where a word is inside the heap.
+static size_t *slot_of(word_freq_t *freq) {
+    return &((follow_word_t *) freq)->slot;
+}
+
+// This is a function to put a word at index 'i' of the heap, and remember that it is there.
+static void heap_set(follow_t *follow, size_t i, word_freq_t *freq) {
+    follow->heap[i] = freq;
+    *slot_of(freq) = i;
+}
+
+// This is a function to swap two words of the heap.
+static void heap_swap(follow_t *follow, size_t i, size_t j) {
+    word_freq_t *tmp = follow->heap[i];
+    heap_set(follow, i, follow->heap[j]);
+    heap_set(follow, j, tmp);
+}
+
+// This is a function to move the word at 'i' up the heap, until its parent ranks below it.
+static void sift_up(follow_t *follow, size_t i) {
+    word_freq_t **heap = follow->heap;
+
+    while (i > 0 && ranks_below(heap[i], heap[(i - 1) / 2])) {
+        heap_swap(follow, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+// This is a function to move the word at 'i' down the heap, until both of its children rank above it.
+static void sift_down(follow_t *follow, size_t i) {
+    word_freq_t **heap = follow->heap;
+
+    for (;;) {
+        size_t lowest = i;
+        size_t left = 2 * i + 1, right = 2 * i + 2;
+
+        if (left < follow->heap_len && ranks_below(heap[left], heap[lowest])) {
+            lowest = left;
+        }
+        if (right < follow->heap_len && ranks_below(heap[right], heap[lowest])) {
+            lowest = right;
+        }
+        if (lowest == i) {
+            return;
+        }
+
+        heap_swap(follow, i, lowest);
+        i = lowest;
+    }
+}
+
+// This is a function to update the heap after the count of a word went up by one.
+static void update_top(follow_t *follow, word_freq_t *freq) {
+
+    // A word that ranks below the lowest ranked word of a full heap is not inside it and does not get in. (Most words.)
+    if (follow->heap_len == follow->k && ranks_below(freq, follow->heap[0])) {
+        return;
+    }
+
+    // If the word is inside the heap already, its count went up, so it can only move down.
+    size_t slot = *slot_of(freq);
+    if (slot != NO_SLOT) {
+        sift_down(follow, slot);
+        return;
+    }
+
+    // Otherwise it takes a free place, or the place of the lowest ranked word, which leaves the heap.
+    if (follow->heap_len < follow->k) {
+        heap_set(follow, follow->heap_len++, freq);
+        sift_up(follow, follow->heap_len - 1);
+    }
+    else {
+        *slot_of(follow->heap[0]) = NO_SLOT;
+        heap_set(follow, 0, freq);
+        sift_down(follow, 0);
+    }
+}
+
+// This is a function to count one word.
+int follow_add(void *ctx, const char *word, size_t len) {
+
+    follow_t *follow = ctx;
+    uint32_t hash = word_hash(word, len);
+    word_freq_t *freq = wordtable_find(&follow->table, word, len, hash);
+
+    if (freq != NULL) {
+        freq->count++;
+    }
+    else {
+        freq = word_freq_create_sized(word, len, 1, sizeof(follow_word_t));
+        if (freq == NULL) {
+            return -1;
+        }
+        *slot_of(freq) = NO_SLOT;
+
+        if (wordtable_insert(&follow->table, freq) < 0) {
+            word_freq_free(&freq->link);
+            return -1;
+        }
+        ilist_addlast(&follow->records, &freq->link);
+    }
+
+    follow->n_words++;
+    update_top(follow, freq);
+    return 0;
+}
+
+// This is a function to compare two words by rank, for sorting the heap into a report.
+static int compare_rank(const void *a, const void *b) {
+    const word_freq_t *fa = *(const word_freq_t *const *) a;
+    const word_freq_t *fb = *(const word_freq_t *const *) b;
+
+    return ranks_below(fa, fb) - ranks_below(fb, fa);
+}
+
+// This is a function to get the highest ranked words.
+size_t follow_top(follow_t *follow, const word_freq_t **top) {
+    memcpy(top, follow->heap, follow->heap_len * sizeof(word_freq_t *));
+    qsort(top, follow->heap_len, sizeof(word_freq_t *), compare_rank);
+    return follow->heap_len;
+}
+
+// This is a function to get the total number of words that were counted.
+size_t follow_nwords(follow_t *follow) {
+    return follow->n_words;
+}
+
+// This is a function to get the number of distinct words that were counted.
+size_t follow_ndistinct(follow_t *follow) {
+    return follow->table.length;
+}
+
+// This is a function to get the time in milliseconds, from a clock that does not jump.
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// This is a struct for the file that is being followed, and use 'follow_file_t' as the alias.
+typedef struct follow_file {
+    const char *path; // This is the path of the file.
+    int fd; // This is the open file.
+    off_t offset; // This is how far the file has been read.
+    int inotify_fd; // This is the inotify instance, or -1 if the file is only checked every interval.
+    int watch; // This is the watch on the file, or -1.
+    char *buf; // This is the buffer the appended bytes are read into.
+} follow_file_t;
+
+// This is a function to watch the open file for changes, if inotify is there.
+static void watch_file(follow_file_t *file) {
+#ifdef __linux__
+    if (file->inotify_fd >= 0) {
+        if (file->watch >= 0) {
+            inotify_rm_watch(file->inotify_fd, file->watch);
+        }
+        // IN_ATTRIB is there for when the file is deleted, since the link count changes.
+        file->watch = inotify_add_watch(file->inotify_fd, file->path, IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+    }
+#else
+    (void) file;
+#endif
+}
+
+// This is a function to feed every byte that was appended since the last read to the tokenizer.
+static int read_appended(follow_file_t *file, tokenizer_t *tok) {
+
+    struct stat st;
+    if (fstat(file->fd, &st) < 0) {
+        return -1;
+    }
+
+    // A file that got shorter was truncated, so it is read again from the start. (The counts are kept.)
+    if (S_ISREG(st.st_mode) && st.st_size < file->offset) {
+        fprintf(stderr, "--- %s was truncated, reading it from the start --- \n", basename(file->path));
+
+        if (lseek(file->fd, 0, SEEK_SET) < 0 || tokenizer_finish(tok) < 0) {
+            return -1;
+        }
+        file->offset = 0;
+    }
+
+    for (;;) {
+        ssize_t n = read(file->fd, file->buf, FOLLOW_BUFSIZE);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n < 0 ? -1 : 0;
+        }
+
+        file->offset += n;
+
+        int rv = tokenizer_feed(tok, file->buf, (size_t) n);
+        if (rv < 0) {
+            return rv;
+        }
+    }
+}
+
+// This is a function to switch to the new file at the path, if the file that is open was moved or deleted.
+// Returns 0, or -1 on failure.
+static int reopen_if_rotated(follow_file_t *file, tokenizer_t *tok) {
+
+    struct stat st_open, st_path;
+    if (fstat(file->fd, &st_open) < 0) {
+        return -1;
+    }
+
+    // Keep reading the open file until there is a new one at the path.
+    if (stat(file->path, &st_path) < 0 || (st_path.st_dev == st_open.st_dev && st_path.st_ino == st_open.st_ino)) {
+        return 0;
+    }
+
+    int fd = open(file->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+
+    fprintf(stderr, "--- %s was replaced, following the new file --- \n", basename(file->path));
+
+    // A writer that kept the old file open may have appended to it after the last read, so read it one last time.
+    if (read_appended(file, tok) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    // The last word of the old file ends with it.
+    close(file->fd);
+    file->fd = fd;
+    file->offset = 0;
+    watch_file(file);
+
+    return tokenizer_finish(tok) < 0 ? -1 : 0;
+}
+
+// This is a function to count a file, and keep counting what is appended to it.
+int follow_file(follow_t *follow, const char *path, tokenizer_t *tok, long interval_ms, follow_report_fn report, void *ctx) {
+
+    follow_file_t file = { path, -1, 0, -1, -1, NULL };
+    struct sigaction old_int, old_term; // These are the signal actions from before, they are restored at the end.
+    int handled = 0; // This is set once the signal handlers are installed.
+    int rv = -1;
+
+    file.fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (file.fd < 0) {
+        printf("Error: Failed to open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    file.buf = malloc(FOLLOW_BUFSIZE);
+    if (file.buf == NULL) {
+        printf("Error: Failed to allocate memory for the read buffer. \n");
+        goto cleanup;
+    }
+
+    // Without inotify the file is still checked every interval.
+#ifdef __linux__
+    file.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    watch_file(&file);
+
+    // Stop on SIGINT and SIGTERM, without SA_RESTART so that 'poll' is interrupted.
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = request_stop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+    handled = 1;
+    stop_requested = 0;
+
+    // Count what is inside the file already, and report it straight away.
+    if (read_appended(&file, tok) < 0 || report(ctx, follow) < 0) {
+        goto cleanup;
+    }
+
+    size_t n_reported = follow->n_words;
+    long long next_report = now_ms() + interval_ms;
+
+    while (!stop_requested) {
+        long long timeout = next_report - now_ms();
+        struct pollfd pfd = { file.inotify_fd, POLLIN, 0 };
+
+        int n = poll(&pfd, file.inotify_fd >= 0 ? 1 : 0, timeout > 0 ? (int) timeout : 0);
+        if (n < 0 && errno != EINTR) {
+            printf("Error: Failed to wait for changes to %s: %s\n", path, strerror(errno));
+            goto cleanup;
+        }
+
+        // The events only say that something changed, the file itself says what.
+        if (n > 0) {
+            char events[4096];
+            while (read(file.inotify_fd, events, sizeof(events)) > 0) {
+            }
+        }
+
+        if (read_appended(&file, tok) < 0 || reopen_if_rotated(&file, tok) < 0) {
+            printf("Error: Failed to read the appended text of %s \n", path);
+            goto cleanup;
+        }
+
+        // Only report when new words were counted since the last report.
+        if (now_ms() >= next_report) {
+            if (follow->n_words != n_reported && report(ctx, follow) < 0) {
+                goto cleanup;
+            }
+            n_reported = follow->n_words;
+            next_report = now_ms() + interval_ms;
+        }
+    }
+
+    // The last word of the file ends when following stops, and the final counts are reported.
+    if (tokenizer_finish(tok) < 0 || (follow->n_words != n_reported && report(ctx, follow) < 0)) {
+        goto cleanup;
+    }
+
+    rv = 0;
+
+cleanup:
+    if (handled) {
+        sigaction(SIGINT, &old_int, NULL);
+        sigaction(SIGTERM, &old_term, NULL);
+    }
+    if (file.inotify_fd >= 0) {
+        close(file.inotify_fd);
+    }
+    close(file.fd);
+    free(file.buf);
+    return rv;
+}
+
+// This is a function to free every word and the counter.
+void follow_destroy(follow_t *follow) {
+
+    if (follow == NULL) {
+        return;
+    }
+
+    wordtable_destroy(&follow->table);
+    ilist_destroy(&follow->records, word_freq_free);
+    free(follow->heap);
+    free(follow);
+}
@@ -18,106 +18,191 @@ inline int isnewline(int c) {
     return (c == '\n');
 }
 
-// This function will tokenize text inside a given file. (Every parameter is explained inside 'futil.h'.)
-int ftokenize(FILE *f, list_t *list, size_t strlen_min, int (*csplitfn)(int), int (*cfilterfn)(int), int (*ctransformfn)(int)) {
-    
-    // If the file is NULL, return -1.
-    if (f == NULL) {
-        printf("Error: The file pointer is NULL. \n");
+// This function will initialize a tokenizer.
+int tokenizer_init(tokenizer_t *tok, size_t strlen_min, int (*csplitfn)(int), int (*cfilterfn)(int), int (*ctransformfn)(int), token_fn emit, void *ctx) {
+
+    tok->strlen_min = strlen_min;
+    tok->csplitfn = csplitfn;
+    tok->cfilterfn = cfilterfn;
+    tok->ctransformfn = ctransformfn;
+    tok->emit = emit;
+    tok->ctx = ctx;
+    tok->keep = NULL; // Keep every token until a filter is set.
+    tok->keep_ctx = NULL;
+    tok->bufsize = INITIAL_BUFSIZE; // Set the buffer size to the initial buffer size. (256 bytes.)
+    tok->len = 0; // Initialize the length of the token stored inside the buffer to be zero.
+
+    // Allocate memory for the token buffer.
+    tok->buffer = malloc(tok->bufsize);
+
+    // Check if the memory allocation for the token buffer failed.
+    if (tok->buffer == NULL) {
+        printf("Error: Memory could not be allocated for the temporary buffer. \n");
         return -1;
     }
 
-    int rv = 0; // Integer for the 'return value'.
-    size_t list_len_before = list_length(list); // Check the list length of the list before the tokenization.
-    size_t bufsize = INITIAL_BUFSIZE; // Set the buffer size to the initial buffer size. (256 bytes.)
+    return 0;
+}
 
-    // Allocate memory for a temporary buffer.
-    char *buffer = malloc(bufsize);
-    
-    // Check if the memory allocation for the temporary buffer failed.
-    if (buffer == NULL) {
-        printf("Error: Memory could not be allocated for the temporary buffer. \n");
-        return -1;
-    }
+// This function will set the token filter of a tokenizer.
+void tokenizer_set_filter(tokenizer_t *tok, token_filter_fn keep, void *keep_ctx) {
+    tok->keep = keep;
+    tok->keep_ctx = keep_ctx;
+}
 
-    char *s = buffer; // Set 's' to point to the start of the buffer.
-    size_t len = 0; // Initialize the length of the token stored inside the buffer to be zero.
+// This function will emit the token inside the buffer if it is long enough and passes the filter, and start the next token.
+static int tokenizer_split(tokenizer_t *tok) {
 
-    // While the end of the file has NOT been reached, run the code inside the loop.
-    while (!feof(f)) {
-        
-        // Read the next character from the file, that character is assigned as 'c'.
-        int c = fgetc(f);
+    int rv = 0;
 
-        // If the end of the file has been reached, set the integer 'c' as the return value.
-        if (c < EOF) {
-            printf("Error: Failed to read from the file. \n");
-            rv = c;
-            break;
+    // If the length is bigger or equal to the string length minumum, null-terminate it and emit it, unless the filter drops it.
+    if (tok->len >= tok->strlen_min) {
+        tok->buffer[tok->len] = 0;
+
+        if (tok->keep == NULL || tok->keep(tok->keep_ctx, tok->buffer, tok->len)) {
+            rv = tok->emit(tok->ctx, tok->buffer, tok->len);
         }
+    }
 
-        // If the end of the file is reached or check if a split function is provided and whether it returns a non-zero value.
-        if (c == EOF || (csplitfn && csplitfn(c))) {
-            
-            // If the length is bigger or equal to the string length minumum, set the pointer to point to the start again.
-            if (len >= strlen_min) {
-                *s = 0;
-                
-                // Create (Copy) a new string with the content of the buffer.
-                char *cpy = strdup(buffer);
-                
-                // If the copying failed, return -1 as the return value.
-                if (cpy == NULL) {
-                    printf("Error: Failed to allocate memory for the copy of a new string. \n");
-                    rv = -1;
-                    break;
-                }
+    tok->len = 0; // Reinitialize the length of the token stored inside the buffer to be zero.
+    return rv < 0 ? rv : 0;
+}
 
-                // Add the copied string as the return value and add it last inside the list.
-                rv = list_addlast(list, cpy);
+// This function will tokenize the next 'n' characters of the text.
+int tokenizer_feed(tokenizer_t *tok, const char *data, size_t n) {
 
-                // If the return value is less than zero, free the memory allocated for the copied string.
-                if (rv < 0) {
-                    printf("Error: Adding the copied string last inside the list failed. \n");
-                    free(cpy); // Free the memory for the copied string.
-                    break;
-                }
-            }
+    for (size_t i = 0; i < n; i++) {
+        int c = (unsigned char) data[i];
 
-            s = buffer; // Reset the 's' to point to the start of the buffer.
-            len = 0; // Reinitialize the length of the token stored inside the buffer to be zero.
-        } 
+        // Check whether a split function is provided and whether it returns a non-zero value.
+        if (tok->csplitfn && tok->csplitfn(c)) {
+            int rv = tokenizer_split(tok);
+            if (rv < 0) {
+                return rv;
+            }
+        }
 
         // Check whether the character 'c' should be included in the token.
-        else if (cfilterfn == NULL || cfilterfn(c)) {
-            
+        else if (tok->cfilterfn == NULL || tok->cfilterfn(c)) {
+
             // This will transform the character 'c' to a token if a transformation function is provided.
-            *s = ctransformfn ? ctransformfn(c) : c;
-            len++;
-            s++;
+            tok->buffer[tok->len++] = tok->ctransformfn ? tok->ctransformfn(c) : c;
 
             // If the length is equal to the buffer size - 1, procced.
-            if (len == bufsize - 1) {
-                
+            if (tok->len == tok->bufsize - 1) {
+
                 // The buffer is full, so double its size to make room for more characters as one byte is needed for null-terminator.
-                bufsize *= 2;
-                
-                // Reallocate the memory for a buffer double its size for a buffer named 're-buf'.
-                char *re_buf = realloc(buffer, bufsize);
-                
+                char *re_buf = realloc(tok->buffer, tok->bufsize * 2);
+
                 // Check if the memory allocation failed for the double buffer size.
                 if (re_buf == NULL) {
                     printf("Error: Failed to reallocate memory for the buffer: %s\n", strerror(errno));
-                    rv = -1;
-                    break;
+                    return -1;
                 }
 
-                buffer = re_buf;
+                tok->buffer = re_buf;
+                tok->bufsize *= 2;
             }
         }
     }
 
-    free(buffer); // Free the memory allocated for the buffer.
+    return 0;
+}
+
+// This function will end the text, the end of the text splits the last token.
+int tokenizer_finish(tokenizer_t *tok) {
+    return tokenizer_split(tok);
+}
+
+// This function will free the buffer of a tokenizer.
+void tokenizer_destroy(tokenizer_t *tok) {
+    free(tok->buffer);
+    tok->buffer = NULL;
+}
+
+// This function will feed a whole file to a tokenizer, while a reader thread reads the next blocks of the file.
+int ftokenize_each(FILE *f, tokenizer_t *tok, reader_stats_t *stats) {
+
+    // If the file is NULL, return -1.
+    if (f == NULL) {
+        printf("Error: The file pointer is NULL. \n");
+        return -1;
+    }
+
+    // Start reading the file on the reader thread.
+    reader_t *reader = reader_open(fileno(f));
+    if (reader == NULL) {
+        printf("Error: Failed to start reading the file. \n");
+        return -1;
+    }
+
+    int rv = 0;
+    const char *buf;
+    ssize_t n;
+
+    // Tokenize each buffer as soon as it has been read, while the reader thread reads the next ones.
+    while ((n = reader_next(reader, &buf)) > 0) {
+        rv = tokenizer_feed(tok, buf, n);
+        if (rv < 0) {
+            break;
+        }
+    }
+
+    if (n < 0) {
+        printf("Error: Failed to read from the file. \n");
+        rv = -1;
+    }
+
+    if (reader_close(reader, stats) < 0 && rv >= 0) {
+        printf("Error: Failed to read from the file. \n");
+        rv = -1;
+    }
+
+    // The end of the file splits the last token.
+    if (rv >= 0) {
+        rv = tokenizer_finish(tok);
+    }
+
+    return rv;
+}
+
+// This function adds a copy of each token last inside the list.
+static int add_token(void *ctx, const char *token, size_t len) {
+
+    // Create (Copy) a new string with the content of the token.
+    char *cpy = malloc(len + 1);
+
+    // If the copying failed, return -1 as the return value.
+    if (cpy == NULL) {
+        printf("Error: Failed to allocate memory for the copy of a new string. \n");
+        return -1;
+    }
+    memcpy(cpy, token, len + 1);
+
+    // Add the copied string last inside the list.
+    if (list_addlast(ctx, cpy) < 0) {
+        printf("Error: Adding the copied string last inside the list failed. \n");
+        free(cpy); // Free the memory for the copied string.
+        return -1;
+    }
+
+    return 0;
+}
+
+// This function will tokenize text inside a given file. (Every parameter is explained inside 'futil.h'.)
+int ftokenize(FILE *f, list_t *list, size_t strlen_min, int (*csplitfn)(int), int (*cfilterfn)(int), int (*ctransformfn)(int), token_filter_fn keep, void *keep_ctx, reader_stats_t *stats) {
+
+    size_t list_len_before = list_length(list); // Check the list length of the list before the tokenization.
+    tokenizer_t tok;
+
+    if (tokenizer_init(&tok, strlen_min, csplitfn, cfilterfn, ctransformfn, add_token, list) < 0) {
+        return -1;
+    }
+    tokenizer_set_filter(&tok, keep, keep_ctx);
+
+    int rv = ftokenize_each(f, &tok, stats);
+
+    tokenizer_destroy(&tok); // Free the memory allocated for the buffer.
 
     // Either complete the operation or revert the list state if it failed.
     if (rv < 0) {
@@ -126,12 +211,12 @@ int ftokenize(FILE *f, list_t *list, size_t strlen_min, int (*csplitfn)(int), in
         while (list_length(list) > list_len_before) {
             free(list_poplast(list));
         }
-    } 
-    
+    }
+
     // If the list length is equal to the list length before the operation, print a warning.
     else if (list_len_before == list_length(list)) {
         printf("The list of words is empty. If the file contains tokens, 'list_addlast' is not working. \n");
     }
 
     return rv;
-}
\ No newline at end of file
+}
@@ -0,0 +1,261 @@
+#include "ilist.h"
+#include "common.h"
+#include <stdlib.h>
+
+// This is a function to initialize an empty list.
+void ilist_init(ilist_t *list) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+}
+
+// This is a function to free every record inside the list.
+void ilist_destroy(ilist_t *list, ilink_free_fn link_free) {
+
+    ilink_t *current = list->head;
+    while (current != NULL) {
+        ilink_t *temp = current; // Store the current link, since the record holding it is about to be freed.
+        current = current->next;
+
+        if (link_free) {
+            link_free(temp);
+        }
+    }
+
+    ilist_init(list); // The list itself was not allocated by us, so just leave it empty.
+}
+
+// This is a function to get the number of records inside the list.
+size_t ilist_length(ilist_t *list) {
+    return list->length;
+}
+
+// This is a function to add a record first inside the list.
+void ilist_addfirst(ilist_t *list, ilink_t *link) {
+
+    link->next = list->head;
+    link->prev = NULL;
+
+    // If the list is empty, the new link is the tail too, otherwise link the old head back to it.
+    if (list->tail == NULL) {
+        list->tail = link;
+    }
+    else {
+        list->head->prev = link;
+    }
+
+    list->head = link;
+    list->length++;
+}
+
+// This is a function to add a record last inside the list.
+void ilist_addlast(ilist_t *list, ilink_t *link) {
+
+    link->next = NULL;
+    link->prev = list->tail;
+
+    // If the list is empty, the new link is the head too, otherwise link the old tail forward to it.
+    if (list->tail == NULL) {
+        list->head = link;
+    }
+    else {
+        list->tail->next = link;
+    }
+
+    list->tail = link;
+    list->length++;
+}
+
+// This is a function to move every record of 'other' to the end of the list.
+void ilist_concat(ilist_t *list, ilist_t *other) {
+
+    if (other->head == NULL) {
+        return;
+    }
+
+    // Link the tail of the list to the head of 'other', or take over its head if the list is empty.
+    if (list->tail == NULL) {
+        list->head = other->head;
+    }
+    else {
+        list->tail->next = other->head;
+        other->head->prev = list->tail;
+    }
+
+    list->tail = other->tail;
+    list->length += other->length;
+    ilist_init(other);
+}
+
+// This is a function to unlink a record from anywhere inside the list.
+void ilist_remove(ilist_t *list, ilink_t *link) {
+
+    if (link->prev) {
+        link->prev->next = link->next;
+    }
+    else {
+        list->head = link->next;
+    }
+
+    if (link->next) {
+        link->next->prev = link->prev;
+    }
+    else {
+        list->tail = link->prev;
+    }
+
+    link->next = NULL;
+    link->prev = NULL;
+    list->length--;
+}
+
+// This is a function to remove the first record inside the list.
+ilink_t *ilist_popfirst(ilist_t *list) {
+
+    ilink_t *link = list->head;
+    if (link != NULL) {
+        ilist_remove(list, link);
+    }
+    return link;
+}
+
+// This is a function to remove the last record inside the list.
+ilink_t *ilist_poplast(ilist_t *list) {
+
+    ilink_t *link = list->tail;
+    if (link != NULL) {
+        ilist_remove(list, link);
+    }
+    return link;
+}
+
+// This is a function to fix the previous links and the tail after the next links have been sorted.
+static void relink(ilist_t *list) {
+    ilink_t *prev = NULL;
+
+    for (ilink_t *link = list->head; link != NULL; link = link->next) {
+        link->prev = prev;
+        prev = link;
+    }
+
+    list->tail = prev;
+}
+
+/* ---- MERGESORT ---- */
+
+// This is the same mergesort as in 'linkedlist.c', working on the links instead of the nodes.
+static ilink_t *merge(ilink_t *a, ilink_t *b, ilink_cmp_fn cmpfn) {
+
+    ilink_t *head, *tail;
+
+    // Choose between the smallest head link by using the comparison function.
+    if (cmpfn(a, b) < 0) {
+        head = tail = a;
+        a = a->next;
+    }
+    else {
+        head = tail = b;
+        b = b->next;
+    }
+
+    // Keep on repeatedly picking the smallest head link.
+    while (a && b) {
+        if (cmpfn(a, b) < 0) {
+            tail->next = a;
+            tail = a;
+            a = a->next;
+        }
+        else {
+            tail->next = b;
+            tail = b;
+            b = b->next;
+        }
+    }
+
+    // Append the remaining non-empty list. (If there are any.)
+    tail->next = a ? a : b;
+
+    return head;
+}
+
+// Split the given list in two halves and return the head of the second half.
+static ilink_t *splitlist(ilink_t *head) {
+
+    ilink_t *slow = head;
+    ilink_t *fast = head->next;
+
+    while (fast != NULL && fast->next != NULL) {
+        slow = slow->next;
+        fast = fast->next->next;
+    }
+
+    ilink_t *half = slow->next;
+    slow->next = NULL;
+
+    return half;
+}
+
+// This is recursive mergesort.
+static ilink_t *mergesort_(ilink_t *head, ilink_cmp_fn cmpfn) {
+
+    if (head->next == NULL) {
+        return head;
+    }
+
+    ilink_t *half = splitlist(head);
+    head = mergesort_(head, cmpfn);
+    half = mergesort_(half, cmpfn);
+
+    return merge(head, half, cmpfn);
+}
+
+// This is a function to sort the entire list by using the Mergesort algorithm.
+void ilist_sort(ilist_t *list, ilink_cmp_fn cmpfn) {
+
+    if (list->head == NULL) {
+        return;
+    }
+
+    list->head = mergesort_(list->head, cmpfn);
+    relink(list);
+}
+
+/* ---- RADIX SORT ---- */
+
+// This is a function to sort the entire list by an integer key using LSD radix sort.
+int ilist_sort_by_key(ilist_t *list, ilink_key_fn keyfn) {
+
+    size_t n = list->length;
+
+    // A list with less than two records is already sorted.
+    if (n < 2) {
+        return 0;
+    }
+
+    // Allocate the pairs and a scratch array of the same size for the radix sort.
+    keyed_t *pairs = malloc(2 * n * sizeof(keyed_t));
+    if (pairs == NULL) {
+        return -1;
+    }
+
+    size_t i = 0;
+    ilist_foreach(link, list) {
+        pairs[i].key = keyfn(link);
+        pairs[i].ptr = link;
+        i++;
+    }
+
+    keyed_t *sorted = radix_sort_keyed(pairs, pairs + n, n);
+
+    // Chain the next links in sorted order, then fix the previous links.
+    list->head = sorted[0].ptr;
+    for (i = 0; i + 1 < n; i++) {
+        ((ilink_t *) sorted[i].ptr)->next = sorted[i + 1].ptr;
+    }
+    ((ilink_t *) sorted[n - 1].ptr)->next = NULL;
+
+    relink(list);
+
+    free(pairs);
+    return 0;
+}
@@ -1,6 +1,8 @@
 
 #include "list.h"
+#include "threadpool.h"
 #include <stdlib.h>
+#include <string.h>
 
 // Define a struct for the nodes inside the linked list.
 typedef struct lnode lnode_t;
@@ -45,18 +47,141 @@ list_t *list_create(cmp_fn cmpfn) {
     return list; // Return the list.    
 }
 
-// This is a function to destroy a list.
-void list_destroy(list_t *list, free_fn item_free) {
-    
-    // Check if the list is empty, if so return.
-    if (list == NULL) {
-        return;
+/* ---- PARALLEL BULK OPERATIONS ---- */
+
+// Lists with less than twice this many nodes are processed as one segment, since handing out segments costs more than it saves.
+#define MIN_SEGMENT_LEN 16384
+
+// Each thread gets about this many segments, so a thread that falls behind does not hold up the others for long.
+#define SEGMENTS_PER_THREAD 4
+
+// This is a struct for a run of consecutive nodes that one task processes.
+typedef struct segment {
+    lnode_t *first; // This is the first node of the segment.
+    size_t len; // This is how many nodes are inside the segment.
+    void *acc; // This is the accumulator of the segment, for 'list_reduce'.
+    int rv; // This is what processing the segment returned.
+} segment_t;
+
+// This is a definition for a function that processes one segment.
+typedef int (*segment_fn)(void *ctx, segment_t *seg);
+
+// This is a struct for everything the tasks of one bulk operation need.
+typedef struct bulk {
+    segment_t *segs; // These are the segments, one per task.
+    segment_fn fn; // This is called with each segment.
+    void *ctx; // This is passed to 'fn'.
+} bulk_t;
+
+// This is a function to get the node after 'node', and start loading the node after that and the item of the next one.
+// The next node is read, so this must not be called on the last node of a segment whose next segment may be freed.
+static inline lnode_t *next_prefetch(lnode_t *node) {
+    lnode_t *next = node->next;
+
+    if (next) {
+        PREFETCH(next->next);
+        PREFETCH(next->item);
+    }
+    return next;
+}
+
+// This is a function that runs one task of a bulk operation.
+static void run_segment(void *ctx, size_t task) {
+    bulk_t *bulk = ctx;
+    bulk->segs[task].rv = bulk->fn(bulk->ctx, &bulk->segs[task]);
+}
+
+// This is a function to split the list into segments and call 'fn' with each of them, on the shared thread pool if there is one.
+// For 'list_reduce', every segment gets its own copy of the 'acc_size' bytes at 'acc', and afterwards 'join' combines
+// the copies into 'acc' in list order. Returns the value of the first segment that returned a negative value, or 0.
+static int process_segments(list_t *list, segment_fn fn, void *ctx, void *acc, size_t acc_size, list_combine_fn join) {
+
+    size_t n = 1;
+
+    // The shared pool starts its workers when it is first used, so a short list does not ask for it.
+    threadpool_t *pool = list->length >= 2 * MIN_SEGMENT_LEN ? threadpool_shared() : NULL;
+
+    if (pool) {
+        n = threadpool_size(pool) * SEGMENTS_PER_THREAD;
+
+        if (n > list->length / MIN_SEGMENT_LEN) {
+            n = list->length / MIN_SEGMENT_LEN;
+        }
     }
 
-    lnode_t *current = list->head; // Make the pointer point at the head of the list.
-    while (current != NULL) {
-        lnode_t *temp = current; // Store the current node in a temporary pointer.
-        current = current->next; // Move to the next node while holding the data from the current pointer.
+    segment_t *segs = NULL;
+    char *copies = NULL;
+
+    if (n > 1) {
+        segs = malloc(n * sizeof(segment_t));
+        copies = acc_size ? malloc((n - 1) * acc_size) : NULL;
+
+        // If there is no memory for the segments, the list is processed as one segment instead.
+        if (segs == NULL || (acc_size && copies == NULL)) {
+            free(segs);
+            free(copies);
+            n = 1;
+        }
+    }
+
+    if (n == 1) {
+        segment_t seg = { list->head, list->length, acc, 0 };
+        return fn(ctx, &seg);
+    }
+
+    // Walk the chain once to find where each segment starts. The lengths differ by at most one.
+    lnode_t *node = list->head;
+    size_t len = list->length / n;
+    size_t extra = list->length % n;
+
+    for (size_t i = 0; i < n; i++) {
+        segs[i].first = node;
+        segs[i].len = len + (i < extra);
+        segs[i].acc = acc;
+        segs[i].rv = 0;
+
+        // The first segment folds straight into 'acc', the others start from a copy of its initial value.
+        if (acc_size && i > 0) {
+            segs[i].acc = copies + (i - 1) * acc_size;
+            memcpy(segs[i].acc, acc, acc_size);
+        }
+
+        if (i + 1 < n) {
+            for (size_t j = 0; j < segs[i].len; j++) {
+                node = next_prefetch(node);
+            }
+        }
+    }
+
+    bulk_t bulk = { segs, fn, ctx };
+    threadpool_run(pool, n, run_segment, &bulk);
+
+    // Combine in list order, so the result does not depend on which thread finished first.
+    int rv = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (join && i > 0) {
+            join(ctx, acc, segs[i].acc);
+        }
+        if (rv >= 0) {
+            rv = segs[i].rv;
+        }
+    }
+
+    free(segs);
+    free(copies);
+    return rv;
+}
+
+// This is a function to free the nodes of a segment and their items, 'ctx' is the 'free_fn' for the items or NULL.
+static int destroy_segment(void *ctx, segment_t *seg) {
+    free_fn item_free = (free_fn) ctx;
+    lnode_t *node = seg->first;
+
+    for (size_t i = 0; i < seg->len; i++) {
+        lnode_t *temp = node; // Store the current node in a temporary pointer.
+
+        // Move to the next node before the current one is freed. (The node after the segment belongs to another thread.)
+        node = i + 1 < seg->len ? next_prefetch(node) : NULL;
 
         // This will free the contents inside the node itself.
         if (item_free) {
@@ -66,23 +191,100 @@ void list_destroy(list_t *list, free_fn item_free) {
         free(temp); // Free the previous node.
     }
 
-    free(list); // This will free the list, since memory was allocated in 'list_create'.
+    return 0;
 }
 
-// This is a function to get the length of a list. (By looking at how many nodes are inside the list.)
-size_t list_length(list_t *list) {
+// This is a struct for the callback of 'list_foreach'.
+typedef struct foreach {
+    list_foreach_fn fn; // This is called with each item.
+    void *ctx; // This is passed to 'fn'.
+} foreach_t;
+
+// This is a function to call the callback of 'list_foreach' with the items of a segment.
+static int foreach_segment(void *ctx, segment_t *seg) {
+    foreach_t *foreach = ctx;
+    lnode_t *node = seg->first;
+
+    for (size_t i = 0; i < seg->len; i++, node = i < seg->len ? next_prefetch(node) : NULL) {
+        int rv = foreach->fn(foreach->ctx, node->item);
+
+        if (rv < 0) {
+            return rv;
+        }
+    }
+
+    return 0;
+}
+
+// This is a function to call 'fn' with every item of the list.
+int list_foreach(list_t *list, list_foreach_fn fn, void *ctx) {
+    foreach_t foreach = { fn, ctx };
+    return process_segments(list, foreach_segment, &foreach, NULL, 0, NULL);
+}
+
+// This is a struct for the callbacks of 'list_reduce'.
+typedef struct reduce {
+    list_fold_fn fold; // This folds an item into an accumulator.
+    list_combine_fn combine; // This combines two accumulators.
+    void *ctx; // This is passed to both of them.
+} reduce_t;
+
+// This is a function to fold the items of a segment into the accumulator of the segment.
+static int reduce_segment(void *ctx, segment_t *seg) {
+    reduce_t *reduce = ctx;
+    lnode_t *node = seg->first;
+
+    for (size_t i = 0; i < seg->len; i++, node = i < seg->len ? next_prefetch(node) : NULL) {
+        reduce->fold(reduce->ctx, seg->acc, node->item);
+    }
+
+    return 0;
+}
+
+// This is a function to combine the accumulators of two neighbouring segments.
+static void reduce_join(void *ctx, void *acc, void *other) {
+    reduce_t *reduce = ctx;
+    reduce->combine(reduce->ctx, acc, other);
+}
+
+// This is a function to reduce the list into the accumulator 'acc'.
+void list_reduce(list_t *list, void *acc, size_t acc_size, list_fold_fn fold, list_combine_fn combine, void *ctx) {
+    reduce_t reduce = { fold, combine, ctx };
+    process_segments(list, reduce_segment, &reduce, acc, acc_size, reduce_join);
+}
+
+// This is a function to destroy a list.
+void list_destroy(list_t *list, free_fn item_free) {
     
-    size_t count = 0; // Set the counter to start at zero.
-    lnode_t *current = list->head; // Have a current pointer point to the head of the list, because we want to start at the first node.
+    // Check if the list is empty, if so return.
+    if (list == NULL) {
+        return;
+    }
+
+    // Free the nodes and their items, on the calling thread. (See 'destroy_segment'.)
+    segment_t seg = { list->head, list->length, NULL, 0 };
+    destroy_segment((void *) item_free, &seg);
+
+    free(list); // This will free the list, since memory was allocated in 'list_create'.
+}
 
-    // While the node is not empty, count the node by incrementing the counter and go to the next node.
-    while (current != NULL) {
-        count++;
-        current = current->next;
+// This is a function to destroy a list, freeing its segments on the shared thread pool.
+void list_destroy_parallel(list_t *list, free_fn item_free) {
+
+    // Check if the list is empty, if so return.
+    if (list == NULL) {
+        return;
     }
 
-    // Return the counter.
-    return count;
+    // Free the nodes and their items, segment by segment. (See 'destroy_segment'.)
+    process_segments(list, destroy_segment, (void *) item_free, NULL, 0, NULL);
+
+    free(list); // This will free the list, since memory was allocated in 'list_create'.
+}
+
+// This is a function to get the length of a list. (The length is kept up to date by every function that adds or removes a node.)
+size_t list_length(list_t *list) {
+    return list->length;
 }
 
 // This is a function to add a element first inside the list.
@@ -378,4 +580,54 @@ void list_sort(list_t *list) {
     }
 
     list->tail = prev; // Set the tail of the list to the last node.
+}
+
+/* ---- RADIX SORT ---- */
+
+// This is a function to sort the entire list by an integer key using LSD radix sort.
+int list_sort_by_key(list_t *list, key_fn keyfn) {
+
+    size_t n = list->length;
+
+    // A list with less than two items is already sorted.
+    if (n < 2) {
+        return 0;
+    }
+
+    // Allocate the pairs and a scratch array of the same size for the radix sort.
+    keyed_t *pairs = malloc(2 * n * sizeof(keyed_t));
+    if (pairs == NULL) {
+        return -1;
+    }
+
+    // Call the key function once per item.
+    size_t i = 0;
+    for (lnode_t *node = list->head; node != NULL; node = node->next, i++) {
+        pairs[i].key = keyfn(node->item);
+        pairs[i].ptr = node;
+    }
+
+    keyed_t *sorted = radix_sort_keyed(pairs, pairs + n, n);
+
+    // Relink the nodes in sorted order and fix the head, the tail and the previous links.
+    lnode_t *prev = NULL;
+
+    for (i = 0; i < n; i++) {
+        lnode_t *node = sorted[i].ptr;
+        node->prev = prev;
+        node->next = NULL;
+
+        if (prev) {
+            prev->next = node;
+        }
+        else {
+            list->head = node;
+        }
+        prev = node;
+    }
+
+    list->tail = prev; // Set the tail of the list to the last node.
+
+    free(pairs);
+    return 0;
 }
\ No newline at end of file
@@ -2,6 +2,14 @@
 #include "common.h"
 #include "futil.h"
 #include "list.h"
+#include "ilist.h"
+#include "wordfreq.h"
+#include "server.h"
+#include "spill.h"
+#include "ngram.h"
+#include "prefixindex.h"
+#include "wordset.h"
+#include "follow.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -9,308 +17,841 @@
 #include <errno.h>
 #include <ctype.h>
 
-// This is a struct that represents a single word-frequency pair. The alias is 'word_freq_t'.
-typedef struct word_freq {
-    char *word; // This is a pointer to the word.
-    size_t count; // This is how many times that word appears.
-} word_freq_t;
-
-// This is a function to sort the 'word_freq_t'.
-int compare_word_freq_by_count(word_freq_t *a, word_freq_t *b) {
-    
-    // If the counter to 'a' is larger than the counter to 'b', return -1. 
-    if (a->count > b->count) {
+// This is a struct for the parsed command line arguments, and use 'options_t' as the alias.
+typedef struct options {
+    char *fpath; // This is the path to the file that will be read.
+    size_t min_wc; // Exclude words that occur less times than this value.
+    size_t min_wl; // Exclude words shorter than this value.
+    size_t lim_nres; // Print at most this many results, 0 to print all.
+    char *serve_path; // This is the path of the socket to serve queries on, or NULL to print the results and exit.
+    int stats; // This is set to print how long reading and tokenizing the file took.
+    size_t max_memory; // This is the memory budget for counting, or 0 to keep every word in memory.
+    char *tmpdir; // This is the directory for the run files, when counting within a memory budget.
+    size_t ngram; // This is how many consecutive words are counted together, or 0 to count single words.
+    output_format_t format; // This is the format the results are printed in.
+    char *save_index; // This is the path to save a prefix index of the counts to, or NULL.
+    int load_index; // This is set if <fpath> is a prefix index to load, instead of a text file to count.
+    char *prefix; // This is the prefix the printed words must start with, or NULL for every word.
+    int stopwords; // This is set to leave out the stopwords that are built into the program.
+    char *stopwords_file; // This is the path to a file with more words to leave out, or NULL.
+    wordset_t *exclude; // These are the words that are left out, or NULL to count every word. (See 'load_exclude'.)
+    int follow; // This is set to keep counting what is appended to the file, and report the top words every interval.
+    long interval_ms; // This is the interval between two reports when following, in milliseconds.
+} options_t;
+
+// This is a function that will print out how to use the arguments and the program, incase someone fails.
+static void print_usage(char **argv) {
+    fprintf(stderr, "Usage: ./%s [options] <fpath> <min_wc> <min_wl> <lim_n_results>\n", basename(argv[0]));
+    fprintf(stderr, "* <fpath>: Path to a readable file. The file will never be modified. \n");
+    fprintf(stderr, "* <min_wc>: Exclude words that occur less times than this value. 1 to include all. \n");
+    fprintf(stderr, "* <min_wl>: Exclude words shorter than this value. 1 to include all. \n");
+    fprintf(stderr, "* <lim_n_results>: Print at most this many results. 0 to print all. \n");
+    fprintf(stderr, "Options: \n");
+    fprintf(stderr, "* --serve <socket>: Keep the counts in memory and answer queries on a Unix socket until stopped. \n");
+    fprintf(stderr, "  The positional arguments are then the defaults for queries that leave them out. \n");
+    fprintf(stderr, "* --max-memory <size>: Count within this many bytes (K, M and G suffixes work), spilling partial counts to disk. The size is for the whole program. \n");
+    fprintf(stderr, "* --tmpdir <dir>: The directory for the spilled counts. ($TMPDIR or /tmp by default.) \n");
+    fprintf(stderr, "* --ngram <n>: Count runs of n consecutive words (of at least <min_wl> chars) instead of single words. 1 to %d. \n", NGRAM_MAX);
+    fprintf(stderr, "* --format <text|tsv|csv|json>: Print the results as a table (default), or in a format for other programs. \n");
+    fprintf(stderr, "* --save-index <path>: Also save a prefix index of the counts, that --load-index can read back. \n");
+    fprintf(stderr, "* --load-index: <fpath> is a prefix index from --save-index, so nothing has to be counted. \n");
+    fprintf(stderr, "* --prefix <prefix>: Only print the words that start with the prefix, ranked by count. \n");
+    fprintf(stderr, "* --stopwords: Leave out common English words such as \"the\" and \"and\", from a set built into the program. \n");
+    fprintf(stderr, "* --stopwords-file <path>: Leave out every word inside the file too. \n");
+    fprintf(stderr, "* --follow: Keep counting what is appended to the file, and print the top <lim_n_results> words again every interval. \n");
+    fprintf(stderr, "  Stop with Ctrl+C. The file is only read once, after that only the new text is read. \n");
+    fprintf(stderr, "* --interval <seconds>: The time between two reports with --follow. (%g by default.) \n", FOLLOW_DEFAULT_INTERVAL / 1000.0);
+    fprintf(stderr, "* --stats: Print how long reading and tokenizing took, and how much of it overlapped, to stderr. \n");
+    fprintf(stderr, "--- \n");
+    fprintf(stderr, "Example 1: %s src/wordfreq.c 10 2 10 \n", argv[0]);
+    fprintf(stderr, "Example 2: %s data/oxford_dict.txt 1 13 25 \n", argv[0]);
+    fprintf(stderr, "Example 3: make run ARGS=\"data/oxford_dict.txt 100 4 25\" \n");
+    fprintf(stderr, "Example 4: %s --serve /tmp/wordfrequency.sock data/oxford_dict.txt 1 1 25 \n", argv[0]);
+    fprintf(stderr, "Example 5: %s --ngram 2 data/oxford_dict.txt 10 1 25 \n", argv[0]);
+    fprintf(stderr, "Example 6: %s --format tsv data/oxford_dict.txt 1 1 0 > counts.tsv \n", argv[0]);
+    fprintf(stderr, "Example 7: %s --save-index oxford.idx data/oxford_dict.txt 1 1 10 \n", argv[0]);
+    fprintf(stderr, "Example 8: %s --load-index --prefix hou oxford.idx 1 1 10 \n", argv[0]);
+    fprintf(stderr, "Example 9: %s --stopwords data/oxford_dict.txt 1 1 25 \n", argv[0]);
+    fprintf(stderr, "Example 10: %s --follow --interval 5 --stopwords /var/log/app.log 1 3 20 \n", argv[0]);
+}
+
+// This is a function that will parse a size in bytes, with an optional K, M or G suffix.
+static int parse_size(const char *s, size_t *size) {
+
+    char *end;
+    errno = 0;
+    unsigned long long v = strtoull(s, &end, 10);
+
+    if (errno || end == s || s[0] == '-') {
         return -1;
     }
 
-    // If the counter to 'a' is smaller than the counter to 'b', return 1. 
-    if (a->count < b->count) {
-        return 1;
+    switch (toupper((unsigned char) *end)) {
+        case 'G': v <<= 10; /* fall through */
+        case 'M': v <<= 10; /* fall through */
+        case 'K': v <<= 10; end++; break;
+        default: break;
+    }
+
+    if (*end != 0) {
+        return -1;
+    }
+
+    *size = (size_t) v;
+    return 0;
+}
+
+// This is a function that will parse the command line arguments into 'opts'.
+static int parse_args(int argc, char **argv, options_t *opts) {
+
+    char *positional[4];
+    int n_positional = 0;
+
+    opts->serve_path = NULL;
+    opts->stats = 0;
+    opts->max_memory = 0;
+    opts->ngram = 0;
+    opts->format = FORMAT_TEXT;
+    opts->save_index = NULL;
+    opts->load_index = 0;
+    opts->prefix = NULL;
+    opts->stopwords = 0;
+    opts->stopwords_file = NULL;
+    opts->exclude = NULL;
+    opts->follow = 0;
+    opts->interval_ms = 0;
+    opts->tmpdir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+
+    // Options start with "--" and may go anywhere, everything else is a positional argument.
+    for (int i = 1; i < argc; i++) {
+        char *arg = argv[i];
+
+        if (strncmp(arg, "--", 2) != 0) {
+            if (n_positional == 4) {
+                printf("Error: Too many positional arguments. \n");
+                print_usage(argv);
+                return -1;
+            }
+            positional[n_positional++] = arg;
+            continue;
+        }
+
+        // These options do not take a value.
+        if (strcmp(arg, "--stats") == 0) {
+            opts->stats = 1;
+            continue;
+        }
+        if (strcmp(arg, "--load-index") == 0) {
+            opts->load_index = 1;
+            continue;
+        }
+        if (strcmp(arg, "--stopwords") == 0) {
+            opts->stopwords = 1;
+            continue;
+        }
+        if (strcmp(arg, "--follow") == 0) {
+            opts->follow = 1;
+            continue;
+        }
+
+        // Every other option takes a value.
+        if (i + 1 == argc) {
+            printf("Error: Missing the value for \"%s\". \n", arg);
+            print_usage(argv);
+            return -1;
+        }
+
+        if (strcmp(arg, "--serve") == 0) {
+            opts->serve_path = argv[++i];
+        }
+        else if (strcmp(arg, "--max-memory") == 0) {
+            if (parse_size(argv[++i], &opts->max_memory) < 0 || opts->max_memory < SPILL_MIN_MEMORY) {
+                printf("Error: Bad argument \"%s\" for --max-memory, it must be at least %d MiB. \n", argv[i], SPILL_MIN_MEMORY >> 20);
+                return -1;
+            }
+        }
+        else if (strcmp(arg, "--tmpdir") == 0) {
+            opts->tmpdir = argv[++i];
+        }
+        else if (strcmp(arg, "--ngram") == 0) {
+            long n = strtol(argv[++i], NULL, 10);
+            if (n < 1 || n > NGRAM_MAX) {
+                printf("Error: Bad argument \"%s\" for --ngram, it must be between 1 and %d. \n", argv[i], NGRAM_MAX);
+                return -1;
+            }
+            opts->ngram = (size_t) n;
+        }
+        else if (strcmp(arg, "--save-index") == 0) {
+            opts->save_index = argv[++i];
+        }
+        else if (strcmp(arg, "--prefix") == 0) {
+            // Words are counted in lower case, so the prefix is in lower case too.
+            opts->prefix = argv[++i];
+            for (char *c = opts->prefix; *c; c++) {
+                *c = tolower((unsigned char) *c);
+            }
+        }
+        else if (strcmp(arg, "--stopwords-file") == 0) {
+            opts->stopwords_file = argv[++i];
+        }
+        else if (strcmp(arg, "--interval") == 0) {
+            char *end;
+            errno = 0;
+            double seconds = strtod(argv[++i], &end);
+
+            // The whole argument has to be a number, like for 'parse_size'.
+            if (errno || end == argv[i] || *end != '\0' || !(seconds * 1000 >= FOLLOW_MIN_INTERVAL && seconds <= 86400)) {
+                printf("Error: Bad argument \"%s\" for --interval, it must be between %g and 86400 seconds. \n", argv[i], FOLLOW_MIN_INTERVAL / 1000.0);
+                return -1;
+            }
+            opts->interval_ms = (long) (seconds * 1000);
+        }
+        else if (strcmp(arg, "--format") == 0) {
+            if (parse_output_format(argv[++i], &opts->format) < 0) {
+                printf("Error: Bad argument \"%s\" for --format, it must be text, tsv, csv or json. \n", argv[i]);
+                return -1;
+            }
+        }
+        else {
+            printf("Error: Unknown option \"%s\". \n", arg);
+            print_usage(argv);
+            return -1;
+        }
+    }
+
+    // The spill counter only counts single words.
+    if (opts->ngram && opts->max_memory) {
+        printf("Error: --ngram cannot be combined with --max-memory. \n");
+        return -1;
+    }
+
+    // The server looks the counts up by single words, and filters them by word length per query.
+    if (opts->ngram && opts->serve_path) {
+        printf("Error: --ngram cannot be combined with --serve. \n");
+        return -1;
+    }
+
+    // A loaded index has been counted already.
+    if (opts->load_index && (opts->ngram || opts->max_memory || opts->save_index || opts->stopwords || opts->stopwords_file)) {
+        printf("Error: --load-index cannot be combined with --ngram, --max-memory, --save-index or --stopwords. \n");
+        return -1;
+    }
+
+    // Following counts single words in memory, and reports them itself.
+    if (opts->follow && (opts->serve_path || opts->max_memory || opts->ngram || opts->save_index || opts->load_index || opts->prefix)) {
+        printf("Error: --follow cannot be combined with --serve, --max-memory, --ngram or the prefix index. \n");
+        return -1;
+    }
+    if (opts->interval_ms && !opts->follow) {
+        printf("Error: --interval only works with --follow. \n");
+        return -1;
+    }
+    if (opts->interval_ms == 0) {
+        opts->interval_ms = FOLLOW_DEFAULT_INTERVAL;
+    }
+
+    // Check if the positional argument count is exactly 4.
+    if (n_positional != 4) {
+        printf("Error: Missing one or more required positional arguments. \n");
+        print_usage(argv);
+        return -1;
+    }
+
+    errno = 0; // Reset the error to 0 to clear any previous errors.
+
+    // Convert the second argument (min_wc) from a string to long.
+    long min_wc_ = strtol(positional[1], NULL, 10);
+    if (errno) {
+        printf("Error: Bad argument \"%s\" for <min_wc>: %s\n", positional[1], strerror(errno));
+        return -1;
+    }
+
+    // Convert the third argument (min_wl) from a string to long.
+    long min_wl_ = strtol(positional[2], NULL, 10);
+    if (errno) {
+        printf("Error: Bad argument \"%s\" for <min_wl>: %s\n", positional[2], strerror(errno));
+        return -1;
+    }
+
+    // Convert the fourth argument (lim_nres) from a string to long.
+    long lim_nres_ = strtol(positional[3], NULL, 10);
+    if (errno) {
+        printf("Error: Bad argument \"%s\" for <lim_n_results>: %s\n", positional[3], strerror(errno));
+        return -2;
+    }
+
+    // Assign the file path.
+    opts->fpath = positional[0];
+
+    // Ensure that min_wc is at least 1, otherwise set it to 1.
+    opts->min_wc = (min_wc_ < 1) ? 1 : (size_t) min_wc_;
+
+    // Ensure that min_wl is at least 1, otherwise set it to 1.
+    opts->min_wl = (min_wl_ < 1) ? 1 : (size_t) min_wl_;
+
+    // Ensure that lim_nres is non-negative, otherwise set it to 0.
+    opts->lim_nres = (lim_nres_ < 0) ? 0 : (size_t) lim_nres_;
+
+    // Following keeps only the top words up to date, so it needs to know how many.
+    if (opts->follow && opts->lim_nres == 0) {
+        printf("Error: --follow needs <lim_n_results> to be at least 1. \n");
+        return -1;
     }
 
     return 0;
 }
 
-// Free the 'word_freq_t', deallocate its memory.
-void word_freq_free(word_freq_t *freq) {
-    free(freq->word);
-    free(freq);
+// This is a struct for what is known about one segment of the words, see 'check_sorted'.
+typedef struct sorted_acc {
+    const char *first; // This is the first word of the segment, or NULL if the segment is empty.
+    const char *last; // This is the last word of the segment.
+    int sorted; // This is cleared if two neighbouring words are out of order.
+} sorted_acc_t;
+
+// This is a function to add the next word to a segment, and check it against the word before it.
+static void sorted_fold(void *ctx, void *acc, void *item) {
+    sorted_acc_t *seg = acc;
+    (void) ctx;
+
+    if (seg->first == NULL) {
+        seg->first = item;
+    }
+    else if (strcmp(seg->last, item) > 0) {
+        seg->sorted = 0;
+    }
+    seg->last = item;
 }
 
-// This is where a list is created to hold word-frequency pairs.
-static list_t *create_wordfreqs_list(list_t *words) {
+// This is a function to join a segment with the segment after it, and check the two words where they meet.
+static void sorted_combine(void *ctx, void *acc, void *other) {
+    sorted_acc_t *seg = acc;
+    sorted_acc_t *next = other;
+    (void) ctx;
 
-    // Call the 'list_create' function to create a new list.
-    list_t *freqs = list_create((cmp_fn) compare_word_freq_by_count);
+    if (next->first == NULL) {
+        return;
+    }
 
-    // Check if the list was created successfully.
-    if (freqs == NULL) {
-        printf("Error: Failed to create a list for the frequency pairs. \n");
-        goto err_cleanup;
+    if (seg->first == NULL) {
+        *seg = *next;
+        return;
     }
 
-    // Create a iterator to iterate over the words inside the list.
-    list_iter_t *words_iter = list_createiter(words);
+    seg->sorted &= next->sorted && strcmp(seg->last, next->first) <= 0;
+    seg->last = next->last;
+}
 
-    // Check if the iterator for the words was created successfully.
-    if (words_iter == NULL) {
-        printf("Error: Failed to create list iterator for the frequency pairs. \n");
-        goto err_cleanup;
+// This is a function to check if every word has to be counted and kept, instead of only the words that will be printed.
+// The server filters per query, and the prefix index is filtered when it is queried, so it can be saved and loaded.
+static int keep_every_word(const options_t *opts) {
+    return opts->serve_path || opts->save_index || opts->prefix;
+}
+
+// This is a function that will check if every word inside the list is in order, returns 0 if it is and -1 if not.
+static int check_sorted(list_t *words) {
+    sorted_acc_t acc = { NULL, NULL, 1 };
+
+    list_reduce(words, &acc, sizeof(sorted_acc_t), sorted_fold, sorted_combine, NULL);
+    return acc.sorted ? 0 : -1;
+}
+
+// This is a function that will count the words of the file by keeping every word in memory and sorting them.
+static int count_in_memory(FILE *infile, options_t *opts, ilist_t *freqs, size_t *n_words, size_t *n_distinct, reader_stats_t *stats) {
+
+    ilist_init(freqs);
+    *n_words = 0;
+    *n_distinct = 0;
+
+    // Create a new list to store the words. (This is sorted.)
+    list_t *words = list_create((cmp_fn) strcmp);
+
+    // Check if the memory allocation failed.
+    if (words == NULL) {
+        printf("Error: Failed to create the list for storing words. \n");
+        return -1;
     }
 
-    word_freq_t *freq = NULL;
+    // Tokenize the content of the file into words.
+    // The server and the prefix index filter by word length themselves, so they have to keep the short words too.
+    int rc = ftokenize(infile, words, keep_every_word(opts) ? 1 : opts->min_wl, isspace, isalnum, tolower,
+                       opts->exclude ? wordset_exclude : NULL, opts->exclude, stats);
 
-    // Call 'list_hasnext' and while there are next nodes, keep running the loop.
-    while (list_hasnext(words_iter)) {
+    // If tokenization succeeds and there are words in the list.
+    if (rc >= 0 && list_length(words)) {
 
-        // Get the next word from the iterator.
-        char *word = list_next(words_iter);
+        // Sort the words in the list by calling the 'list_sort' function.
+        list_sort(words);
 
-        // If 'freq' is not NULL and the word in 'freq' matches the current word:
-        if (freq && strcmp(freq->word, word) == 0) {
-            freq->count++; // Increment the count of that word.
-            continue;
+        // Ensure the list is sorted correctly.
+        if (check_sorted(words) < 0) {
+            printf("Error: The list is not sorted correctly. \n");
+            rc = -1;
         }
 
-        // Allocate memory for a new word-frequency pair.
-        freq = malloc(sizeof(word_freq_t));
-        if (freq == NULL) {
-            printf("Error: Cannot allocate memory for a new wor-frequency pair. \n");
-            goto err_cleanup;
+        // If no errors occurred during sorting, create the word-frequency list by counting word occurrences.
+        if (rc >= 0) {
+            rc = create_wordfreqs_list(words, freqs);
+            *n_words = list_length(words);
+            *n_distinct = ilist_length(freqs);
         }
+    }
+
+    list_destroy_parallel(words, free); // Free the words and the list. (The list is long, and 'free' is thread-safe.)
+    return rc;
+}
+
+// This is a struct for the results of a query on the prefix index, see 'collect_result'.
+typedef struct collect {
+    ilist_t *freqs; // The results are added last in this list.
+    size_t min_wc; // Stop at the first word that occurs less times than this.
+    size_t min_wl; // Skip the words shorter than this.
+    size_t lim_nres; // Stop after this many results, or 0 for all.
+    int failed; // This is set if a result could not be allocated.
+} collect_t;
+
+// This is a function to add a result of the prefix index to the list, as a word-frequency pair.
+static int collect_result(void *ctx, const char *word, size_t len, size_t count) {
+    collect_t *collect = ctx;
+
+    // The results come by descending count, so none of the rest occur often enough either.
+    if (count < collect->min_wc) {
+        return 1;
+    }
+    if (len < collect->min_wl) {
+        return 0;
+    }
+
+    word_freq_t *freq = word_freq_create(word, len, count);
+    if (freq == NULL) {
+        collect->failed = 1;
+        return 1;
+    }
+
+    ilist_addlast(collect->freqs, &freq->link);
+    return collect->lim_nres && ilist_length(collect->freqs) >= collect->lim_nres;
+}
 
-        freq->count = 1; // Initialize the frequency count of the new word to 1, because its the first time the word appears.
-        freq->word = strdup(word); // Duplicate the word. (Allocate memory and copy the word.)
+// This is a function that will count the words of the file within the '--max-memory' budget, spilling counts to run files.
+// The results are only read back into 'freqs' if they are all needed at once, otherwise the counter is stored in 'spilled'
+// so they can be printed straight from it.
+static int count_spilled(FILE *infile, options_t *opts, ilist_t *freqs, spill_t **spilled, size_t *n_words, size_t *n_distinct, reader_stats_t *stats) {
 
-        // Check if the memory allocation for the word failed.
-        if (freq->word == NULL) {
-            printf("Cannot allocate memory\n");
-            free(freq);
-            goto err_cleanup;
+    ilist_init(freqs);
+    *spilled = NULL;
+
+    spill_t *spill = spill_create(opts->max_memory, opts->tmpdir);
+    if (spill == NULL) {
+        printf("Error: Failed to create the spill counter. \n");
+        return -1;
+    }
+
+    tokenizer_t tok;
+    // The server and the prefix index need every word, so they get all of the counts in memory.
+    int keep_all = keep_every_word(opts);
+
+    if (tokenizer_init(&tok, keep_all ? 1 : opts->min_wl, isspace, isalnum, tolower, spill_add, spill) < 0) {
+        spill_destroy(spill);
+        return -1;
+    }
+    if (opts->exclude) {
+        tokenizer_set_filter(&tok, wordset_exclude, opts->exclude);
+    }
+
+    int rc = ftokenize_each(infile, &tok, stats);
+    tokenizer_destroy(&tok);
+
+    if (rc >= 0) {
+        if (keep_all) {
+            rc = spill_finish(spill, 1, 0, n_words, n_distinct);
+        }
+        else {
+            rc = spill_finish(spill, opts->min_wc, opts->lim_nres, n_words, n_distinct);
         }
+    }
+
+    if (rc >= 0 && keep_all) {
+        collect_t collect = { freqs, 1, 1, 0, 0 };
 
-        // Add the newly created word-frequency pair first in the 'freqs' list.
-        if (list_addfirst(freqs, freq) < 0) {
-            printf("Error: 'list_addfirst' failed. \n");
-            word_freq_free(freq); // Free the memory for 'freq'.
-            goto err_cleanup;
+        if (spill_results(spill, collect_result, &collect) < 0 || collect.failed) {
+            printf("Error: Failed to allocate memory for the results. \n");
+            ilist_destroy(freqs, word_freq_free);
+            rc = -1;
         }
     }
 
-    list_destroyiter(words_iter); // Free the iterator.
+    if (rc >= 0 && opts->stats) {
+        fprintf(stderr, "--- Spilled %zu runs to %s ---\n", spill_nruns(spill), opts->tmpdir);
+    }
+
+    if (rc >= 0 && !keep_all) {
+        *spilled = spill;
+        return rc;
+    }
 
-    // Sort the list.
-    list_sort(freqs);
+    spill_destroy(spill);
+    return rc;
+}
 
-    return freqs;
+// This is a function that will count the n-grams of the file, see 'ngram.h'.
+static int count_ngrams(FILE *infile, options_t *opts, ilist_t *freqs, size_t *n_ngrams, size_t *n_distinct, reader_stats_t *stats) {
 
-// This is a cleanup function that will handle memory deallocation. (This is where almost every 'if-statement' goes to.)
-err_cleanup:
+    ilist_init(freqs);
 
-    // If there is a list, destroy it and free its memory.
-    if (freqs) {
-        list_destroy(freqs, (free_fn) word_freq_free);
+    ngram_t *ngram = ngram_create(opts->ngram);
+    if (ngram == NULL) {
+        printf("Error: Failed to create the n-gram counter. \n");
+        return -1;
+    }
+
+    // The n-grams are formed from the words that pass <min_wl>, so it is applied here.
+    tokenizer_t tok;
+    if (tokenizer_init(&tok, opts->min_wl, isspace, isalnum, tolower, ngram_add, ngram) < 0) {
+        ngram_destroy(ngram);
+        return -1;
+    }
+    // A left out word is skipped, so the words on both sides of it form an n-gram.
+    if (opts->exclude) {
+        tokenizer_set_filter(&tok, wordset_exclude, opts->exclude);
+    }
+
+    int rc = ftokenize_each(infile, &tok, stats);
+    tokenizer_destroy(&tok);
+
+    if (rc >= 0) {
+        rc = ngram_finish(ngram, freqs, n_ngrams);
     }
 
-    return NULL;
+    if (rc < 0) {
+        printf("Error: Failed to allocate memory for counting the n-grams. \n");
+    }
+    else {
+        *n_distinct = ilist_length(freqs);
+    }
+
+    ngram_destroy(ngram);
+    return rc;
 }
 
-// This is a function that will print out the word frequency list, shows the result.
-static int print_wordfreqs_list(list_t *freqs, size_t min_wc, size_t lim_nres) {
-    
-    // Create a iterator, so that we can display the results.
-    list_iter_t *freqs_iter = list_createiter(freqs);
-    
-    // Check if the memory allocation was successful.
-    if (freqs_iter == NULL) {
-        printf("Error: Failed to create an iterator. \n");
+// This is a struct for the totals that are printed above the results, see 'add_total'.
+typedef struct totals {
+    size_t min_wl; // Only the words of at least this many chars are counted.
+    const char *prefix; // Only the words that start with this are counted as distinct words.
+    size_t prefix_len; // This is the length of the prefix.
+    size_t n_words; // This is the total number of words.
+    size_t n_distinct; // This is the number of distinct words.
+} totals_t;
+
+// This is a function to add a counted word to the totals, it is a 'prefix_fn'.
+static int add_total(void *ctx, const char *word, size_t len, size_t count) {
+    totals_t *totals = ctx;
+
+    if (len < totals->min_wl) {
+        return 0;
+    }
+
+    totals->n_words += count;
+    if (len >= totals->prefix_len && memcmp(word, totals->prefix, totals->prefix_len) == 0) {
+        totals->n_distinct++;
+    }
+    return 0;
+}
+
+// This is a function that will save the counts as a prefix index, or load them from one, and then
+// replace 'freqs' with the words that start with the prefix, if there is one, ranked by count.
+// The index holds every word, so the totals are counted again over the words that pass <min_wl>, like without an index.
+static int use_index(options_t *opts, ilist_t *freqs, size_t *n_words, size_t *n_distinct) {
+
+    prefixindex_t *index;
+
+    if (opts->load_index) {
+        index = prefixindex_load(opts->fpath);
+        if (index == NULL) {
+            printf("Error: Failed to load the index %s, it is missing or not an index. \n", opts->fpath);
+            return -1;
+        }
+        *n_words = prefixindex_total(index);
+    }
+    else {
+        index = prefixindex_build(freqs, *n_words);
+        if (index == NULL) {
+            printf("Error: Failed to allocate memory for the prefix index. \n");
+            return -1;
+        }
+    }
+
+    if (opts->save_index && prefixindex_save(index, opts->save_index) < 0) {
+        printf("Error: Failed to save the index to %s: %s\n", opts->save_index, strerror(errno));
+        prefixindex_destroy(index);
         return -1;
     }
 
-    /* --- These are all of the prints required to display the results in command prompt. */
+    int rc = 0;
+    const char *prefix = opts->prefix ? opts->prefix : "";
+    totals_t totals = { opts->min_wl, prefix, strlen(prefix), 0, 0 };
 
-    printf("Number of distinct words: %zu\n\n", list_length(freqs));
+    // The server gets every word, and the totals of them.
+    if (!opts->serve_path) {
+        if (opts->load_index) {
+            rc = prefixindex_top(index, "", 0, add_total, &totals);
+        }
+        else {
+            ilist_foreach(link, freqs) {
+                word_freq_t *freq = ilist_entry(link, word_freq_t, link);
+                add_total(&totals, word_freq_word(freq), freq->len, freq->count);
+            }
+        }
 
-    printf("--- Words that occured at least %zu times", min_wc);
-    
-    if (lim_nres) {
-        printf("Error: Limiting to max %zu results. \n", lim_nres);
+        if (rc < 0) {
+            printf("Error: Failed to allocate memory for the results. \n");
+            prefixindex_destroy(index);
+            return -1;
+        }
+        *n_words = totals.n_words;
+        *n_distinct = totals.n_distinct;
+    }
+    else if (opts->load_index || opts->prefix) {
+        *n_distinct = prefixindex_count(index, prefix, strlen(prefix));
     }
 
-    printf(" ---\n");
+    // The counts saved in the index include the short words, so the printed results are read back from it too.
+    if (opts->load_index || opts->prefix || !opts->serve_path) {
 
-    printf("%-30s   %s\n", "TERM", "COUNT");
+        // The server filters per query, so it gets every word.
+        collect_t collect = { freqs, 1, 1, 0, 0 };
+        if (!opts->serve_path) {
+            collect.min_wc = opts->min_wc;
+            collect.min_wl = opts->min_wl;
+            collect.lim_nres = opts->lim_nres;
+        }
 
-    size_t n_printed = 0; // Initilize the printed count.
+        ilist_destroy(freqs, word_freq_free);
 
-    // This is a loop required to print out the results to the command prompt:
-    while (list_hasnext(freqs_iter) && (lim_nres == 0 || n_printed < lim_nres)) {
-        word_freq_t *freq = list_next(freqs_iter);
-        if (freq->count >= min_wc) {
-            printf("%-30s | %zu\n", freq->word, freq->count);
-            n_printed++;
+        if (prefixindex_top(index, prefix, strlen(prefix), collect_result, &collect) < 0 || collect.failed) {
+            printf("Error: Failed to allocate memory for the results. \n");
+            rc = -1;
         }
     }
 
-    list_destroyiter(freqs_iter);
-    return 0;
+    prefixindex_destroy(index);
+    return rc;
 }
 
-// This is a function that will print out how to use the arguments and the program, incase someone fails.
-static int parse_args(int argc, char **argv, char **fpath, size_t *min_wc, size_t *min_wl, size_t *lim_nres) {
-   
-    // Check if the argument count is exactly 5.
-    if (argc != 5) {
+// This is a function that will set up the words that '--stopwords' and '--stopwords-file' leave out.
+// The built in stopwords are a table generated when the program is built, a file is only known when it runs.
+static int load_exclude(options_t *opts, wordset_t *exclude) {
 
-        // These are just all of the print statements that will show up as a guide.
-        printf("Error: Missing one or more required positional arguments. \n");
-        fprintf(stderr, "Usage: ./%s <fpath> <min_wc> <min_wl> <lim_n_results>\n", basename(argv[0]));
-        fprintf(stderr, "* <fpath>: Path to a readable file. The file will never be modified. \n");
-        fprintf(stderr, "* <min_wc>: Exclude words that occur less times than this value. 1 to include all. \n");
-        fprintf(stderr, "* <min_wl>: Exclude words shorter than this value. 1 to include all. \n");
-        fprintf(stderr, "* <lim_n_results>: Print at most this many results. 0 to print all. \n");
-        fprintf(stderr, "--- \n");
-        fprintf(stderr, "Example 1: %s src/wordfreq.c 10 2 10 \n", argv[0]);
-        fprintf(stderr, "Example 2: %s data/oxford_dict.txt 1 13 25 \n", argv[0]);
-        fprintf(stderr, "Example 3: make run ARGS=\"data/oxford_dict.txt 100 4 25\" \n");
+    if (!opts->stopwords && !opts->stopwords_file) {
+        return 0;
+    }
+
+    if (wordset_init(exclude) < 0) {
+        printf("Error: Failed to allocate memory for the stopwords. \n");
         return -1;
     }
 
-    errno = 0; // Reset the error to 0 to clear any previous errors.
+    if (opts->stopwords) {
+        wordset_add_builtin(exclude, &phf_stopwords);
+    }
 
-    // Convert the second argument (min_wc) from a string to long.
-    long min_wc_ = strtol(argv[2], NULL, 10);
-    if (errno) {
-        printf("Error: Bad argument \"%s\" for <min_wc>: %s\n", argv[2], strerror(errno));
+    if (opts->stopwords_file && wordset_load(exclude, opts->stopwords_file) < 0) {
+        printf("Error: Failed to read the stopwords from %s \n", opts->stopwords_file);
+        wordset_destroy(exclude);
         return -1;
     }
 
-    // Convert the third argument (min_wl) from a string to long.
-    long min_wl_ = strtol(argv[3], NULL, 10);
-    if (errno) {
-        printf("Error: Bad argument \"%s\" for <min_wl>: %s\n", argv[3], strerror(errno));
+    opts->exclude = exclude;
+    return 0;
+}
+
+// This is a struct for what a report needs when following a file, see 'print_report'.
+typedef struct report {
+    options_t *opts; // These are the options, for the header and the filters.
+    const word_freq_t **top; // This is room for the <lim_n_results> top words.
+} report_t;
+
+// This is a function that will print the top words of a followed file, it is called every interval. (See 'follow.h'.)
+static int print_report(void *ctx, follow_t *follow) {
+
+    report_t *report = ctx;
+    options_t *opts = report->opts;
+
+    if (opts->format == FORMAT_TEXT) {
+        printf("\n--- %s | Words consisting of at least %zu chars --- \n", basename(opts->fpath), opts->min_wl);
+        printf("Total number of words: %zu\n", follow_nwords(follow));
+    }
+
+    size_t n = follow_top(follow, report->top);
+    return print_wordfreqs_array(report->top, n, follow_ndistinct(follow), opts->min_wc, opts->lim_nres, opts->format);
+}
+
+// This is a function that will count the file, and keep counting and reporting what is appended to it until stopped.
+static int follow_words(options_t *opts) {
+
+    follow_t *follow = follow_create(opts->lim_nres);
+    report_t report = { opts, calloc(opts->lim_nres, sizeof(word_freq_t *)) };
+
+    if (follow == NULL || report.top == NULL) {
+        printf("Error: Failed to create the follow counter. \n");
+        follow_destroy(follow);
+        free(report.top);
         return -1;
     }
 
-    // Convert the fourth argument (lim_nres) from a string to long.
-    long lim_nres_ = strtol(argv[4], NULL, 10);
-    if (errno) {
-        printf("Error: Bad argument \"%s\" for <lim_n_results>: %s\n", argv[4], strerror(errno));
-        return -2;
+    tokenizer_t tok;
+    int rc = tokenizer_init(&tok, opts->min_wl, isspace, isalnum, tolower, follow_add, follow);
+
+    if (rc >= 0) {
+        if (opts->exclude) {
+            tokenizer_set_filter(&tok, wordset_exclude, opts->exclude);
+        }
+
+        rc = follow_file(follow, opts->fpath, &tok, opts->interval_ms, print_report, &report);
+        tokenizer_destroy(&tok);
     }
 
-    // Assign the file path to the fpath pointer.
-    *fpath = argv[1];
+    follow_destroy(follow);
+    free(report.top);
+    return rc;
+}
 
-    // Ensure that min_wc is at least 1, otherwise set it to 1.
-    *min_wc = (min_wc_ < 1) ? 1 : (size_t) min_wc_;
+// This is a function that will print the results of the spill counter as they are merged, see 'spill_results'.
+static int print_spilled(spill_t *spill, size_t n_distinct, options_t *opts) {
 
-    // Ensure that min_wl is at least 1, otherwise set it to 1.
-    *min_wl = (min_wl_ < 1) ? 1 : (size_t) min_wl_;
+    wordfreq_printer_t printer;
+    if (wordfreq_printer_init(&printer, n_distinct, opts->min_wc, opts->lim_nres, opts->format) < 0) {
+        return -1;
+    }
 
-    // Ensure that lim_nres is non-negative, otherwise set it to 0.
-    *lim_nres = (lim_nres_ < 0) ? 0 : (size_t) lim_nres_;
+    int rc = spill_results(spill, wordfreq_printer_add, &printer);
 
-    return 0;
+    if (wordfreq_printer_finish(&printer) < 0) {
+        rc = -1;
+    }
+    return rc;
 }
 
 // This is the main function.
 int main(int argc, char **argv) {
-    
-    char *fpath;
-    
-    // Declare the size of 'min_wc', 'min_wl' and 'lim_nres'.
-    size_t min_wc, min_wl, lim_nres;
 
-    // Parse the command line arguments and assign values to fpath, min_wc, min_wl, and lim_nres.
+    options_t opts;
+
+    // Parse the command line arguments into 'opts'.
     // If parsing fails exit, the program.
-    int rc = parse_args(argc, argv, &fpath, &min_wc, &min_wl, &lim_nres);
-    
+    int rc = parse_args(argc, argv, &opts);
+
     // If 'rc' is less than 0, return.
     if (rc < 0) {
         return -1;
     }
 
-    // Open the file given.
-    FILE *infile = fopen(fpath, "r");
-    
-    // If file opening fails, print an error message and exit.
-    if (!infile) { 
-        printf("Error: Failed to open %s: %s\n", fpath, strerror(errno));
-        return -1;
+    ilist_t freqs;
+    spill_t *spill = NULL; // This holds the results instead of 'freqs', if they were spilled to disk.
+    size_t n_words = 0, n_distinct = 0;
+    reader_stats_t stats;
+    wordset_t exclude;
+
+    if (opts.follow) {
+        // Following reports the counts itself, until it is stopped.
+        if (load_exclude(&opts, &exclude) < 0) {
+            return EXIT_FAILURE;
+        }
+
+        rc = follow_words(&opts);
+
+        if (opts.exclude) {
+            wordset_destroy(opts.exclude);
+        }
+        return rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
     }
 
-    // Create a new list to store the words. (This is sorted.)
-    list_t *words = list_create((cmp_fn) strcmp);
+    if (opts.load_index) {
+        // The counts come from the index instead, see 'use_index'.
+        ilist_init(&freqs);
+    }
+    else {
+        // Open the file given.
+        FILE *infile = fopen(opts.fpath, "r");
+
+        // If file opening fails, print an error message and exit.
+        if (!infile) {
+            printf("Error: Failed to open %s: %s\n", opts.fpath, strerror(errno));
+            return -1;
+        }
 
-    // Check if the memory allocation failed.
-    if (words == NULL) { 
-        printf("Error: Failed to create the list for storing words. \n");
-        fclose(infile); // Close the opened file to avoid resource leak.
-        return -1;
+        if (load_exclude(&opts, &exclude) < 0) {
+            fclose(infile);
+            return EXIT_FAILURE;
+        }
+
+        // Count the words or the n-grams, within the memory budget if one was given.
+        if (opts.ngram) {
+            rc = count_ngrams(infile, &opts, &freqs, &n_words, &n_distinct, &stats);
+        }
+        else if (opts.max_memory) {
+            rc = count_spilled(infile, &opts, &freqs, &spill, &n_words, &n_distinct, &stats);
+        }
+        else {
+            rc = count_in_memory(infile, &opts, &freqs, &n_words, &n_distinct, &stats);
+        }
+
+        fclose(infile); // Close the file after processing is complete.
+
+        if (opts.exclude) {
+            wordset_destroy(opts.exclude);
+            opts.exclude = NULL;
+        }
+
+        if (rc < 0) {
+            return EXIT_FAILURE;
+        }
+
+        if (opts.stats) {
+            reader_print_stats(stderr, &stats);
+        }
     }
 
-    // Tokenize the content of the file into words.
-    rc = ftokenize(infile, words, min_wl, isspace, isalnum, tolower);
-    
-    // If tokenization succeeds and there are words in the list.
-    if (rc >= 0 && list_length(words)) {
-        
-        // Sort the words in the list by calling the 'list_sort' function.
-        list_sort(words);
-    
-        // Ensure the list is sorted correctly.
-        list_iter_t *iter = list_createiter(words);
-        
-        if (iter) {
-            // Get the first word from the list.
-            void *prev = list_next(iter);
-
-            // Iterate through the list and check if it is sorted.
-            while (list_hasnext(iter)) {
-                void *curr = list_next(iter);
-
-                // If the list is not sorted, print an error.
-                if (strcmp(prev, curr) > 0) {
-                    printf("Error: The list is not sorted correctly. \n");
-                    list_destroyiter(iter);
-                    rc = -1;
-                    break;
-                }
-
-                prev = curr; // Update previous to the current word for the next iteration.
-            }
+    // Save, load or query the prefix index.
+    if (opts.save_index || opts.load_index || opts.prefix) {
+        rc = use_index(&opts, &freqs, &n_words, &n_distinct);
 
-            list_destroyiter(iter); // Destroy the iterator.
+        if (rc < 0) {
+            ilist_destroy(&freqs, word_freq_free);
+            return EXIT_FAILURE;
         }
-    
-        // If no errors occurred during sorting.
-        if (rc >= 0) {
+    }
 
-            // Create the word-frequency list by counting word occurrences.
-            list_t *freqs = create_wordfreqs_list(words);
-    
-            // If frequency list creation is successful.
-            if (freqs) {
-
-                // Print the header information about the file and word length requirements.
-                printf("\n--- %s | Words consisting of at least %zu chars --- \n", basename(fpath), min_wl);
-                printf("Total number of words: %zu\n", list_length(words));
-    
-                // Print the word frequencies.
-                rc = print_wordfreqs_list(freqs, min_wc, lim_nres);
-
-                // Free the frequency list memory.
-                list_destroy(freqs, (free_fn) word_freq_free);
-            } 
-            else {
-                rc = -1; // If frequency list creation failed, set 'rc' to -1 to mark it as failure.
-            }
+    if (opts.serve_path) {
+        server_data_t data = { &freqs, n_words, opts.min_wc, opts.min_wl, opts.lim_nres };
+        rc = serve_wordfreqs(opts.serve_path, &data);
+    }
+    else if (n_words) {
+        // Print the header information about the file and word length requirements. (Only the table has a header.)
+        if (opts.format == FORMAT_TEXT && opts.prefix) {
+            printf("\n--- %s | Words starting with \"%s\" consisting of at least %zu chars --- \n", basename(opts.fpath), opts.prefix, opts.min_wl);
+            printf("Total number of words: %zu\n", n_words);
+        }
+        else if (opts.format == FORMAT_TEXT && opts.ngram) {
+            printf("\n--- %s | %zu-grams of words consisting of at least %zu chars --- \n", basename(opts.fpath), opts.ngram, opts.min_wl);
+            printf("Total number of %zu-grams: %zu\n", opts.ngram, n_words);
+        }
+        else if (opts.format == FORMAT_TEXT) {
+            printf("\n--- %s | Words consisting of at least %zu chars --- \n", basename(opts.fpath), opts.min_wl);
+            printf("Total number of words: %zu\n", n_words);
+        }
+
+        // Print the word frequencies.
+        if (spill) {
+            rc = print_spilled(spill, n_distinct, &opts);
+        }
+        else {
+            rc = print_wordfreqs_list(&freqs, n_distinct, opts.min_wc, opts.lim_nres, opts.format);
         }
     }
 
-    fclose(infile); // Close the file after processing is complete.
+    // Free the frequency list memory.
+    ilist_destroy(&freqs, word_freq_free);
+    spill_destroy(spill);
 
     // Return success or failure based on the result code. (Rc)
-    return rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS; 
-}
\ No newline at end of file
+    return rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+#include "ngram.h"
+#include "common.h"
+#include "ilist.h"
+#include "wordfreq.h"
+#include "wordtable.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// This is the base of the rolling hash. (An odd 64 bit constant, so multiplying by it loses no bits.)
+#define ROLL_BASE 0x100000001b3ull
+
+// This is the struct for the n-gram counter.
+struct ngram {
+    size_t n; // This is the number of words inside an n-gram.
+    char **tokens; // This is the window, a ring of the last 'n' tokens.
+    size_t *lens; // These are the lengths of the tokens inside the window.
+    size_t *caps; // These are the sizes of the buffers of the tokens inside the window.
+    uint32_t *hashes; // These are the hashes of the tokens inside the window.
+    size_t first; // This is where the oldest token is inside the ring.
+    size_t filled; // This is how many tokens are inside the window, it stays at 'n' once the window is full.
+    uint64_t hash; // This is the rolling hash of the window, the sum of hashes[i] * ROLL_BASE^(n - 1 - i).
+    uint64_t top; // This is ROLL_BASE^(n - 1), the weight of the oldest token.
+    size_t text_len; // This is the length of the n-gram inside the window, with a space after every token.
+    char *scratch; // This is the buffer for joining the window into a new n-gram.
+    size_t scratch_size; // This is the size of that buffer.
+    wordtable_t table; // This indexes the n-grams by their rolling hash.
+    ilist_t records; // These are the n-grams, in the order they were first seen.
+    size_t n_total; // This is how many n-grams have been counted.
+};
+
+// This is a function to create a counter for n-grams of 'n' words.
+ngram_t *ngram_create(size_t n) {
+
+    if (n < 1 || n > NGRAM_MAX) {
+        return NULL;
+    }
+
+    ngram_t *ngram = calloc(1, sizeof(ngram_t));
+    if (ngram == NULL) {
+        return NULL;
+    }
+
+    ngram->n = n;
+    ngram->top = 1;
+    for (size_t i = 1; i < n; i++) {
+        ngram->top *= ROLL_BASE;
+    }
+    ilist_init(&ngram->records);
+
+    ngram->tokens = calloc(n, sizeof(char *));
+    ngram->lens = calloc(n, sizeof(size_t));
+    ngram->caps = calloc(n, sizeof(size_t));
+    ngram->hashes = calloc(n, sizeof(uint32_t));
+
+    if (ngram->tokens == NULL || ngram->lens == NULL || ngram->caps == NULL || ngram->hashes == NULL
+        || wordtable_init(&ngram->table, 0) < 0) {
+        ngram_destroy(ngram);
+        return NULL;
+    }
+
+    return ngram;
+}
+
+// This is a function to mix the 64 bit rolling hash down to the 32 bits that the table uses.
+static uint32_t table_hash(uint64_t hash) {
+    return (uint32_t) ((hash * 0x9e3779b97f4a7c15ull) >> 32);
+}
+
+// This is a function to check if an n-gram is the one inside the window, without joining the window into a string.
+static int window_equals(const word_freq_t *freq, void *ctx) {
+    ngram_t *ngram = ctx;
+
+    if (freq->len != ngram->text_len - 1) {
+        return 0;
+    }
+
+    const char *word = word_freq_word(freq);
+
+    for (size_t i = 0; i < ngram->n; i++) {
+        size_t slot = (ngram->first + i) % ngram->n;
+        size_t len = ngram->lens[slot];
+
+        if (memcmp(word, ngram->tokens[slot], len) != 0) {
+            return 0;
+        }
+        word += len;
+
+        // The words are joined by a single space, and tokens never contain one, so this keeps "a bc" and "ab c" apart.
+        if (i + 1 < ngram->n && *word++ != ' ') {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// This is a function to create a new n-gram from the window, and add it to the table.
+static int add_window(ngram_t *ngram, uint32_t hash) {
+
+    if (ngram->text_len > ngram->scratch_size) {
+        size_t size = ngram->scratch_size ? ngram->scratch_size : 64;
+        while (size < ngram->text_len) {
+            size *= 2;
+        }
+
+        char *scratch = realloc(ngram->scratch, size);
+        if (scratch == NULL) {
+            return -1;
+        }
+        ngram->scratch = scratch;
+        ngram->scratch_size = size;
+    }
+
+    // Join the tokens with a space between each of them.
+    char *dst = ngram->scratch;
+    for (size_t i = 0; i < ngram->n; i++) {
+        size_t slot = (ngram->first + i) % ngram->n;
+
+        memcpy(dst, ngram->tokens[slot], ngram->lens[slot]);
+        dst += ngram->lens[slot];
+        *dst++ = ' ';
+    }
+
+    word_freq_t *freq = word_freq_create(ngram->scratch, ngram->text_len - 1, 1);
+    if (freq == NULL) {
+        return -1;
+    }
+
+    // The table only looks at the cached hash, so it is replaced with the rolling hash that lookups use.
+    freq->hash = hash;
+
+    if (wordtable_insert(&ngram->table, freq) < 0) {
+        word_freq_free(&freq->link);
+        return -1;
+    }
+
+    ilist_addlast(&ngram->records, &freq->link);
+    return 0;
+}
+
+// This is a function to add the next token to the window, and count the n-gram that ends with it.
+int ngram_add(void *ctx, const char *token, size_t len) {
+    ngram_t *ngram = ctx;
+    size_t slot;
+
+    if (ngram->filled == ngram->n) {
+        // The window is full, so the oldest token leaves it and its slot is reused for the new token.
+        slot = ngram->first;
+        ngram->hash -= ngram->hashes[slot] * ngram->top;
+        ngram->text_len -= ngram->lens[slot] + 1;
+        ngram->first = (ngram->first + 1) % ngram->n;
+    }
+    else {
+        slot = (ngram->first + ngram->filled) % ngram->n;
+        ngram->filled++;
+    }
+
+    if (len + 1 > ngram->caps[slot]) {
+        size_t cap = len + 1 < 32 ? 32 : 2 * (len + 1);
+        char *buf = realloc(ngram->tokens[slot], cap);
+
+        if (buf == NULL) {
+            // Forget the window, the counter is not used after a failure anyway.
+            ngram->filled = 0;
+            ngram->hash = 0;
+            ngram->text_len = 0;
+            return -1;
+        }
+        ngram->tokens[slot] = buf;
+        ngram->caps[slot] = cap;
+    }
+
+    memcpy(ngram->tokens[slot], token, len);
+    ngram->lens[slot] = len;
+    ngram->hashes[slot] = word_hash(token, len);
+    ngram->hash = ngram->hash * ROLL_BASE + ngram->hashes[slot];
+    ngram->text_len += len + 1;
+
+    // There is no n-gram until the first 'n' tokens have been seen.
+    if (ngram->filled < ngram->n) {
+        return 0;
+    }
+
+    ngram->n_total++;
+
+    uint32_t hash = table_hash(ngram->hash);
+    word_freq_t *freq = wordtable_find_match(&ngram->table, hash, window_equals, ngram);
+
+    if (freq) {
+        freq->count++;
+        return 0;
+    }
+    return add_window(ngram, hash);
+}
+
+// This is a function to move the counted n-grams into 'freqs'.
+int ngram_finish(ngram_t *ngram, ilist_t *freqs, size_t *n_total) {
+
+    // The table points into the records, so it is emptied before they are handed over.
+    wordtable_destroy(&ngram->table);
+
+    // Sort alphabetically and then by count, so n-grams with the same count are in alphabetical order.
+    ilist_sort(&ngram->records, compare_word_freq_by_word);
+
+    if (ilist_sort_by_key(&ngram->records, word_freq_count_key) < 0) {
+        return -1;
+    }
+
+    *freqs = ngram->records;
+    *n_total = ngram->n_total;
+    ilist_init(&ngram->records);
+    return 0;
+}
+
+// This is a function to free the counter.
+void ngram_destroy(ngram_t *ngram) {
+
+    if (ngram == NULL) {
+        return;
+    }
+
+    if (ngram->tokens) {
+        for (size_t i = 0; i < ngram->n; i++) {
+            free(ngram->tokens[i]);
+        }
+    }
+
+    free(ngram->tokens);
+    free(ngram->lens);
+    free(ngram->caps);
+    free(ngram->hashes);
+    free(ngram->scratch);
+    wordtable_destroy(&ngram->table);
+    ilist_destroy(&ngram->records, word_freq_free);
+    free(ngram);
+}
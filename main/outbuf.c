@@ -0,0 +1,138 @@
+#include "outbuf.h"
+#include "common.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+// These are the numbers from 00 to 99 as two digits each, so a number is formatted two digits at a time.
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// This is a function to initialize an output buffer.
+int outbuf_init(outbuf_t *out, int fd, size_t size) {
+
+    out->fd = fd;
+    out->size = size ? size : OUTBUF_SIZE;
+    out->len = 0;
+    out->error = 0;
+    out->buf = malloc(out->size);
+
+    if (out->buf == NULL) {
+        return -1;
+    }
+    return 0;
+}
+
+// This is a function to write 'n' bytes to the file descriptor, retrying until all of them are written.
+static int write_all(outbuf_t *out, const char *data, size_t n) {
+
+    if (out->error) {
+        return -1;
+    }
+
+    while (n > 0) {
+        ssize_t rv = write(out->fd, data, n);
+
+        if (rv < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            out->error = errno;
+            return -1;
+        }
+
+        data += rv;
+        n -= (size_t) rv;
+    }
+
+    return 0;
+}
+
+// This is a function to write everything inside the buffer.
+int outbuf_flush(outbuf_t *out) {
+    size_t len = out->len;
+
+    out->len = 0;
+    return write_all(out, out->buf, len);
+}
+
+// This is a function to flush the buffer and free it.
+int outbuf_destroy(outbuf_t *out) {
+    int rv = outbuf_flush(out);
+
+    free(out->buf);
+    out->buf = NULL;
+    return rv;
+}
+
+// This is a function to add 'n' bytes to the buffer.
+int outbuf_write(outbuf_t *out, const char *data, size_t n) {
+
+    if (out->len + n > out->size) {
+        if (outbuf_flush(out) < 0) {
+            return -1;
+        }
+
+        // Something larger than the whole buffer is written straight away instead of being copied in pieces.
+        if (n > out->size) {
+            return write_all(out, data, n);
+        }
+    }
+
+    memcpy(out->buf + out->len, data, n);
+    out->len += n;
+    return 0;
+}
+
+// This is a function to add 'n' copies of a character to the buffer.
+int outbuf_fill(outbuf_t *out, char c, size_t n) {
+
+    while (n > 0) {
+        if (out->len == out->size && outbuf_flush(out) < 0) {
+            return -1;
+        }
+
+        size_t chunk = out->size - out->len < n ? out->size - out->len : n;
+        memset(out->buf + out->len, c, chunk);
+        out->len += chunk;
+        n -= chunk;
+    }
+
+    return 0;
+}
+
+// This is a function to add the decimal digits of a number to the buffer.
+int outbuf_putu(outbuf_t *out, size_t value) {
+
+    // Fill a small buffer from the end, two digits at a time. (A 64 bit number has at most 20 digits.)
+    char digits[20];
+    char *p = digits + sizeof(digits);
+
+    while (value >= 100) {
+        size_t pair = (value % 100) * 2;
+        value /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+
+    if (value >= 10) {
+        *--p = digit_pairs[value * 2 + 1];
+        *--p = digit_pairs[value * 2];
+    }
+    else {
+        *--p = (char) ('0' + value);
+    }
+
+    return outbuf_write(out, p, (size_t) (digits + sizeof(digits) - p));
+}
@@ -0,0 +1,18 @@
+#include "phf.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// This is a function to check if a word is inside a generated table.
+int phf_contains(const phf_t *phf, const char *word, size_t len) {
+
+    if (phf->n_keys == 0) {
+        return 0;
+    }
+
+    // The bucket of the word gives the seed, and the seed gives the only slot the word can be in.
+    uint32_t seed = phf->seeds[phf_hash(0, word, len) % phf->n_buckets];
+    size_t slot = phf_hash(seed, word, len) % phf->n_keys;
+
+    return phf->lens[slot] == len && memcmp(phf->keys[slot], word, len) == 0;
+}
@@ -0,0 +1,549 @@
+#include "prefixindex.h"
+#include "common.h"
+#include "ilist.h"
+#include "wordfreq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// These identify an index file, and the version of its layout.
+#define INDEX_MAGIC "WFPI"
+#define INDEX_VERSION 1
+
+// This marks an empty node of the segment tree.
+#define NO_WORD UINT32_MAX
+
+// This is the struct for the header of an index file. The arrays follow it in the order of the fields of 'prefixindex'.
+// (Everything is stored in the byte order of the machine that saved it.)
+typedef struct index_header {
+    char magic[4]; // This is INDEX_MAGIC.
+    uint32_t version; // This is INDEX_VERSION.
+    uint64_t n_words; // This is the number of distinct words.
+    uint64_t n_total; // This is the total number of words that were counted.
+    uint64_t max_len; // This is the length of the longest word.
+    uint64_t data_size; // This is the size of the front-coded words.
+    uint64_t leaves; // This is the number of leaves of the segment tree.
+} index_header_t;
+
+// This is the struct for the prefix index.
+struct prefixindex {
+    size_t n_words; // This is the number of distinct words.
+    size_t n_total; // This is the total number of words that were counted.
+    size_t max_len; // This is the length of the longest word.
+    size_t n_blocks; // This is the number of blocks.
+    uint64_t *blocks; // This is where each block starts inside 'data'.
+    uint64_t *counts; // These are the counts of the words, in alphabetical order.
+    size_t leaves; // This is the number of leaves of the segment tree, a power of two that is at least 'n_words'.
+    uint32_t *tree; // This is the segment tree, node i has the children 2i and 2i + 1, and leaf j is node 'leaves' + j.
+    unsigned char *data; // These are the front-coded words.
+    size_t data_size; // This is the size of 'data'.
+    char *word; // This is a buffer for decoding a word, 'max_len' + 1 bytes.
+};
+
+// This is a struct for a range of words and the word with the highest count inside it, see 'prefixindex_top'.
+typedef struct range {
+    uint32_t first; // This is the first word of the range.
+    uint32_t end; // This is the word after the last word of the range.
+    uint32_t best; // This is the word with the highest count inside the range.
+} range_t;
+
+// This is a function to add a number to 'data' as a varint, 7 bits per byte with the high bit set on every byte but the last.
+static size_t put_varint(unsigned char *data, size_t value) {
+    size_t n = 0;
+
+    while (value >= 0x80) {
+        data[n++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    data[n++] = (unsigned char) value;
+    return n;
+}
+
+// This is a function to read a varint. Returns NULL if it goes past 'end'.
+static const unsigned char *get_varint(const unsigned char *p, const unsigned char *end, size_t *value) {
+    size_t v = 0;
+
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char byte = *p++;
+        v |= (size_t) (byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0) {
+            *value = v;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// This is a function to decode the next word of a block into 'word', which holds the word before it.
+// 'head' is set for the first word of a block. Returns the position of the word after it, or NULL if the data is invalid.
+static const unsigned char *decode_next(prefixindex_t *index, const unsigned char *p, int head, char *word, size_t *len) {
+
+    const unsigned char *end = index->data + index->data_size;
+    size_t shared = 0;
+    size_t rest;
+
+    if (!head && (p = get_varint(p, end, &shared)) == NULL) {
+        return NULL;
+    }
+    if ((p = get_varint(p, end, &rest)) == NULL) {
+        return NULL;
+    }
+
+    if (shared > *len || rest > index->max_len - shared || rest > (size_t) (end - p)) {
+        return NULL;
+    }
+
+    memcpy(word + shared, p, rest);
+    *len = shared + rest;
+    word[*len] = 0;
+    return p + rest;
+}
+
+// This is a function to decode the first word of a block into the buffer of the index.
+static size_t block_head(prefixindex_t *index, size_t block) {
+    size_t len = 0;
+
+    decode_next(index, index->data + index->blocks[block], 1, index->word, &len);
+    return len;
+}
+
+// This is a function to decode a word into the buffer of the index. Returns its length.
+static size_t word_at(prefixindex_t *index, size_t rank) {
+
+    size_t block = rank / PREFIXINDEX_BLOCK;
+    const unsigned char *p = index->data + index->blocks[block];
+    size_t len = 0;
+
+    for (size_t i = block * PREFIXINDEX_BLOCK; i <= rank; i++) {
+        p = decode_next(index, p, i == block * PREFIXINDEX_BLOCK, index->word, &len);
+    }
+    return len;
+}
+
+// This is a function to compare a word with a prefix: 0 if the word starts with the prefix, otherwise like 'strcmp'.
+static int compare_prefix(const char *word, size_t len, const char *prefix, size_t plen) {
+
+    int rv = memcmp(word, prefix, len < plen ? len : plen);
+
+    if (rv != 0) {
+        return rv;
+    }
+    return len < plen ? -1 : 0;
+}
+
+// This is a function to find the first word that is not before the prefix, or if 'after' is set, the first word after
+// every word that starts with the prefix. The words where that is true come after the words where it is not.
+static size_t search(prefixindex_t *index, const char *prefix, size_t plen, int after) {
+
+    // Find the first block whose first word is past the point, so the point is inside the block before it.
+    size_t lo = 0;
+    size_t hi = index->n_blocks;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t len = block_head(index, mid);
+        int rv = compare_prefix(index->word, len, prefix, plen);
+
+        if (after ? rv > 0 : rv >= 0) {
+            hi = mid;
+        }
+        else {
+            lo = mid + 1;
+        }
+    }
+
+    if (lo == 0) {
+        return 0;
+    }
+
+    // Walk the block before it.
+    size_t first = (lo - 1) * PREFIXINDEX_BLOCK;
+    size_t end = first + PREFIXINDEX_BLOCK < index->n_words ? first + PREFIXINDEX_BLOCK : index->n_words;
+    const unsigned char *p = index->data + index->blocks[lo - 1];
+    size_t len = 0;
+
+    for (size_t i = first; i < end; i++) {
+        p = decode_next(index, p, i == first, index->word, &len);
+        int rv = compare_prefix(index->word, len, prefix, plen);
+
+        if (after ? rv > 0 : rv >= 0) {
+            return i;
+        }
+    }
+    return end;
+}
+
+// This is a function to pick the word with the higher count of two, or the first in alphabetical order if they are equal.
+static uint32_t better(prefixindex_t *index, uint32_t a, uint32_t b) {
+
+    if (a == NO_WORD) {
+        return b;
+    }
+    if (b == NO_WORD) {
+        return a;
+    }
+    if (index->counts[a] != index->counts[b]) {
+        return index->counts[a] > index->counts[b] ? a : b;
+    }
+    return a < b ? a : b;
+}
+
+// This is a function to find the word with the highest count from 'first' up to (not including) 'end'.
+static uint32_t range_best(prefixindex_t *index, size_t first, size_t end) {
+
+    uint32_t best = NO_WORD;
+
+    for (first += index->leaves, end += index->leaves; first < end; first /= 2, end /= 2) {
+        if (first & 1) {
+            best = better(index, best, index->tree[first++]);
+        }
+        if (end & 1) {
+            best = better(index, best, index->tree[--end]);
+        }
+    }
+    return best;
+}
+
+// This is a function to allocate the arrays of an index with the sizes that are already set.
+static prefixindex_t *index_alloc(prefixindex_t *index) {
+
+    index->n_blocks = (index->n_words + PREFIXINDEX_BLOCK - 1) / PREFIXINDEX_BLOCK;
+    index->blocks = malloc((index->n_blocks ? index->n_blocks : 1) * sizeof(uint64_t));
+    index->counts = malloc((index->n_words ? index->n_words : 1) * sizeof(uint64_t));
+    index->tree = malloc(2 * index->leaves * sizeof(uint32_t));
+    index->data = malloc(index->data_size ? index->data_size : 1);
+    index->word = malloc(index->max_len + 1);
+
+    if (index->blocks == NULL || index->counts == NULL || index->tree == NULL || index->data == NULL || index->word == NULL) {
+        prefixindex_destroy(index);
+        return NULL;
+    }
+    return index;
+}
+
+// This is a function to compare two pairs by word, for 'qsort'.
+static int compare_pairs(const void *a, const void *b) {
+    return compare_word_freq_by_word(*(ilink_t *const *) a, *(ilink_t *const *) b);
+}
+
+// This is a function to build an index of the word-frequency pairs inside 'freqs'.
+prefixindex_t *prefixindex_build(ilist_t *freqs, size_t n_total) {
+
+    size_t n = ilist_length(freqs);
+
+    // The segment tree stores the words as 32 bit numbers, and NO_WORD is reserved.
+    if (n >= NO_WORD) {
+        return NULL;
+    }
+
+    // Put the pairs in alphabetical order, without changing the order of the list.
+    ilink_t **links = malloc((n ? n : 1) * sizeof(ilink_t *));
+    if (links == NULL) {
+        return NULL;
+    }
+
+    size_t i = 0;
+    ilist_foreach(link, freqs) {
+        links[i++] = link;
+    }
+    qsort(links, n, sizeof(ilink_t *), compare_pairs);
+
+    prefixindex_t *index = calloc(1, sizeof(prefixindex_t));
+    if (index == NULL) {
+        free(links);
+        return NULL;
+    }
+
+    index->n_words = n;
+    index->n_total = n_total;
+    index->leaves = 1;
+    while (index->leaves < n) {
+        index->leaves *= 2;
+    }
+
+    // Find the size of the front-coded words first, so they can be written into a single array. (A varint of a 64 bit number is at most 10 bytes.)
+    for (i = 0; i < n; i++) {
+        const word_freq_t *freq = ilist_entry(links[i], word_freq_t, link);
+
+        index->max_len = freq->len > index->max_len ? freq->len : index->max_len;
+        index->data_size += 2 * 10 + freq->len;
+    }
+
+    if (index_alloc(index) == NULL) {
+        free(links);
+        return NULL;
+    }
+
+    size_t pos = 0;
+    const word_freq_t *prev = NULL;
+
+    for (i = 0; i < n; i++) {
+        const word_freq_t *freq = ilist_entry(links[i], word_freq_t, link);
+        const char *word = word_freq_word(freq);
+        size_t shared = 0;
+
+        if (i % PREFIXINDEX_BLOCK == 0) {
+            // The first word of a block is stored whole, so a block can be decoded without the blocks before it.
+            index->blocks[i / PREFIXINDEX_BLOCK] = pos;
+        }
+        else {
+            const char *prev_word = word_freq_word(prev);
+            while (shared < prev->len && shared < freq->len && prev_word[shared] == word[shared]) {
+                shared++;
+            }
+            pos += put_varint(index->data + pos, shared);
+        }
+
+        pos += put_varint(index->data + pos, freq->len - shared);
+        memcpy(index->data + pos, word + shared, freq->len - shared);
+        pos += freq->len - shared;
+
+        index->counts[i] = freq->count;
+        prev = freq;
+    }
+
+    free(links);
+
+    // Give back the room that was set aside for the longest possible varints.
+    unsigned char *data = realloc(index->data, pos ? pos : 1);
+    if (data) {
+        index->data = data;
+    }
+    index->data_size = pos;
+
+    // Fill the leaves, and then every node from the bottom up with the better of its two children.
+    for (i = 0; i < index->leaves; i++) {
+        index->tree[index->leaves + i] = i < n ? (uint32_t) i : NO_WORD;
+    }
+    for (i = index->leaves - 1; i >= 1; i--) {
+        index->tree[i] = better(index, index->tree[2 * i], index->tree[2 * i + 1]);
+    }
+    index->tree[0] = NO_WORD;
+
+    return index;
+}
+
+// This is a function to write the index to a file.
+int prefixindex_save(prefixindex_t *index, const char *path) {
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+
+    index_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, 4);
+    header.version = INDEX_VERSION;
+    header.n_words = index->n_words;
+    header.n_total = index->n_total;
+    header.max_len = index->max_len;
+    header.data_size = index->data_size;
+    header.leaves = index->leaves;
+
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1
+        && fwrite(index->blocks, sizeof(uint64_t), index->n_blocks, f) == index->n_blocks
+        && fwrite(index->counts, sizeof(uint64_t), index->n_words, f) == index->n_words
+        && fwrite(index->tree, sizeof(uint32_t), 2 * index->leaves, f) == 2 * index->leaves
+        && fwrite(index->data, 1, index->data_size, f) == index->data_size;
+
+    // The file is only complete once it has been closed without an error.
+    if (fclose(f) != 0) {
+        ok = 0;
+    }
+    return ok ? 0 : -1;
+}
+
+// This is a function to check that a loaded index can be queried without reading outside of its arrays.
+static int index_valid(prefixindex_t *index) {
+
+    for (size_t i = 0; i < 2 * index->leaves; i++) {
+        if (index->tree[i] != NO_WORD && index->tree[i] >= index->n_words) {
+            return 0;
+        }
+    }
+
+    // Decode every word once, which also checks that the blocks start where the words before them end.
+    const unsigned char *p = index->data;
+    size_t len = 0;
+
+    for (size_t i = 0; i < index->n_words; i++) {
+        if (i % PREFIXINDEX_BLOCK == 0 && index->blocks[i / PREFIXINDEX_BLOCK] != (uint64_t) (p - index->data)) {
+            return 0;
+        }
+        if ((p = decode_next(index, p, i % PREFIXINDEX_BLOCK == 0, index->word, &len)) == NULL) {
+            return 0;
+        }
+    }
+    return p == index->data + index->data_size;
+}
+
+// This is a function to read an index written by 'prefixindex_save'.
+prefixindex_t *prefixindex_load(const char *path) {
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    index_header_t header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, INDEX_MAGIC, 4) != 0 || header.version != INDEX_VERSION
+        || header.n_words >= NO_WORD || header.leaves < header.n_words || header.leaves > 2 * header.n_words + 1
+        || (header.leaves & (header.leaves - 1)) != 0 || header.max_len > header.data_size) {
+        fclose(f);
+        return NULL;
+    }
+
+    prefixindex_t *index = calloc(1, sizeof(prefixindex_t));
+    if (index == NULL) {
+        fclose(f);
+        return NULL;
+    }
+
+    index->n_words = header.n_words;
+    index->n_total = header.n_total;
+    index->max_len = header.max_len;
+    index->data_size = header.data_size;
+    index->leaves = header.leaves;
+
+    if (index_alloc(index) == NULL) {
+        fclose(f);
+        return NULL;
+    }
+
+    int ok = fread(index->blocks, sizeof(uint64_t), index->n_blocks, f) == index->n_blocks
+        && fread(index->counts, sizeof(uint64_t), index->n_words, f) == index->n_words
+        && fread(index->tree, sizeof(uint32_t), 2 * index->leaves, f) == 2 * index->leaves
+        && fread(index->data, 1, index->data_size, f) == index->data_size
+        && fgetc(f) == EOF;
+
+    fclose(f);
+
+    if (!ok || !index_valid(index)) {
+        prefixindex_destroy(index);
+        return NULL;
+    }
+    return index;
+}
+
+// This is a function to get the number of distinct words inside the index.
+size_t prefixindex_length(prefixindex_t *index) {
+    return index->n_words;
+}
+
+// This is a function to get the total number of words that were counted.
+size_t prefixindex_total(prefixindex_t *index) {
+    return index->n_total;
+}
+
+// This is a function to get how many words start with the given prefix.
+size_t prefixindex_count(prefixindex_t *index, const char *prefix, size_t len) {
+    return search(index, prefix, len, 1) - search(index, prefix, len, 0);
+}
+
+// This is a function to move a range up the heap of 'prefixindex_top' until its parent is better.
+static void heap_push(prefixindex_t *index, range_t *heap, size_t *n, range_t range) {
+
+    size_t i = (*n)++;
+
+    while (i > 0 && better(index, range.best, heap[(i - 1) / 2].best) == range.best) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = range;
+}
+
+// This is a function to remove the best range from the heap of 'prefixindex_top'.
+static range_t heap_pop(prefixindex_t *index, range_t *heap, size_t *n) {
+
+    range_t top = heap[0];
+    range_t last = heap[--(*n)];
+    size_t i = 0;
+
+    while (2 * i + 1 < *n) {
+        size_t child = 2 * i + 1;
+
+        if (child + 1 < *n && better(index, heap[child + 1].best, heap[child].best) == heap[child + 1].best) {
+            child++;
+        }
+        if (better(index, last.best, heap[child].best) == last.best) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+// This is a function to call 'fn' with the words that start with the given prefix, by descending count.
+int prefixindex_top(prefixindex_t *index, const char *prefix, size_t len, prefix_fn fn, void *ctx) {
+
+    size_t first = search(index, prefix, len, 0);
+    size_t end = search(index, prefix, len, 1);
+
+    if (first >= end) {
+        return 0;
+    }
+
+    // Each range that is taken from the heap gives its best word, and is split in two around it.
+    // So the heap holds at most one range more than the number of words that have been given to 'fn'.
+    size_t cap = 64;
+    size_t n = 0;
+    range_t *heap = malloc(cap * sizeof(range_t));
+
+    if (heap == NULL) {
+        return -1;
+    }
+
+    range_t all = { (uint32_t) first, (uint32_t) end, range_best(index, first, end) };
+    heap_push(index, heap, &n, all);
+
+    while (n > 0) {
+        range_t range = heap_pop(index, heap, &n);
+        size_t word_len = word_at(index, range.best);
+
+        if (fn(ctx, index->word, word_len, index->counts[range.best]) != 0) {
+            break;
+        }
+
+        if (n + 2 > cap) {
+            range_t *new_heap = realloc(heap, 2 * cap * sizeof(range_t));
+            if (new_heap == NULL) {
+                free(heap);
+                return -1;
+            }
+            heap = new_heap;
+            cap *= 2;
+        }
+
+        if (range.first < range.best) {
+            range_t left = { range.first, range.best, range_best(index, range.first, range.best) };
+            heap_push(index, heap, &n, left);
+        }
+        if (range.best + 1 < range.end) {
+            range_t right = { range.best + 1, range.end, range_best(index, range.best + 1, range.end) };
+            heap_push(index, heap, &n, right);
+        }
+    }
+
+    free(heap);
+    return 0;
+}
+
+// This is a function to free the index.
+void prefixindex_destroy(prefixindex_t *index) {
+
+    if (index == NULL) {
+        return;
+    }
+
+    free(index->blocks);
+    free(index->counts);
+    free(index->tree);
+    free(index->data);
+    free(index->word);
+    free(index);
+}
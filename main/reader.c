@@ -0,0 +1,616 @@
+#include "reader.h"
+#include "common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// io_uring is only used if the kernel headers for it are available, the raw system calls are used so no library is needed.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// This is a function to get the current time in seconds.
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ---- IO_URING ---- */
+
+#ifdef HAVE_IO_URING
+
+// This is how many times waiting for the reads in flight is retried, before their buffers are given up on.
+#define URING_DRAIN_RETRIES 1000
+
+// This is a struct for the rings shared with the kernel.
+typedef struct uring {
+    int fd; // This is the io_uring file descriptor.
+    unsigned *sq_tail; // This is the tail of the submission queue, written by us.
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes; // These are the submission queue entries.
+    unsigned *cq_head; // This is the head of the completion queue, written by us.
+    unsigned *cq_tail; // This is the tail of the completion queue, written by the kernel.
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes; // These are the completion queue entries.
+    void *sq_ptr, *cq_ptr; // These are the mapped rings.
+    size_t sq_size, cq_size, sqes_size; // These are the sizes of the mappings.
+} uring_t;
+
+// This is a function to set up an io_uring with room for 'entries' reads in flight.
+// Returns 0 on success, or -1 if the kernel does not support it (the caller then uses 'read()').
+static int uring_setup(uring_t *ring, unsigned entries) {
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0) {
+        return -1;
+    }
+
+    // IORING_OP_READ came with Linux 5.6, and IORING_FEAT_FAST_POLL with 5.7, so use the feature as the version check.
+    if (!(p.features & IORING_FEAT_FAST_POLL)) {
+        close(ring->fd);
+        return -1;
+    }
+
+    ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    // Newer kernels map both rings with a single mapping.
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_size > ring->sq_size) {
+            ring->sq_size = ring->cq_size;
+        }
+        ring->cq_size = ring->sq_size;
+    }
+
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        close(ring->fd);
+        return -1;
+    }
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    }
+    else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            munmap(ring->sq_ptr, ring->sq_size);
+            close(ring->fd);
+            return -1;
+        }
+    }
+
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (ring->cq_ptr != ring->sq_ptr) {
+            munmap(ring->cq_ptr, ring->cq_size);
+        }
+        munmap(ring->sq_ptr, ring->sq_size);
+        close(ring->fd);
+        return -1;
+    }
+
+    ring->sq_tail = (unsigned *) ((char *) ring->sq_ptr + p.sq_off.tail);
+    ring->sq_mask = (unsigned *) ((char *) ring->sq_ptr + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *) ((char *) ring->sq_ptr + p.sq_off.array);
+    ring->cq_head = (unsigned *) ((char *) ring->cq_ptr + p.cq_off.head);
+    ring->cq_tail = (unsigned *) ((char *) ring->cq_ptr + p.cq_off.tail);
+    ring->cq_mask = (unsigned *) ((char *) ring->cq_ptr + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) ((char *) ring->cq_ptr + p.cq_off.cqes);
+
+    return 0;
+}
+
+// This is a function to unmap the rings and close the io_uring.
+static void uring_teardown(uring_t *ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_size);
+    }
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+}
+
+// This is a function to submit a read of 'len' bytes at 'offset' into 'buf', tagged with 'tag'.
+// Returns 0 on success, or -1 if the submission failed.
+static int uring_submit_read(uring_t *ring, int fd, char *buf, size_t len, off_t offset, unsigned long long tag) {
+
+    unsigned tail = *ring->sq_tail;
+    unsigned idx = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long) buf;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = tag;
+
+    ring->sq_array[idx] = idx;
+
+    // The kernel must see the entry before it sees the new tail.
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    int rv;
+    do {
+        rv = syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0);
+    } while (rv < 0 && errno == EINTR);
+
+    return rv == 1 ? 0 : -1;
+}
+
+// This is a function to wait for the next completed read.
+// Returns 0 and stores the tag and the result (bytes read, or a negative errno) on success, or -1 if waiting failed.
+static int uring_wait(uring_t *ring, unsigned long long *tag, int *res) {
+
+    unsigned head = *ring->cq_head;
+
+    while (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        int rv = syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (rv < 0 && errno != EINTR) {
+            return -1;
+        }
+    }
+
+    struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+    *tag = cqe->user_data;
+    *res = cqe->res;
+
+    // Hand the entry back to the kernel after it has been read.
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// This is a function to wait for the 'n' reads that are still in flight, so the kernel no longer writes into their buffers.
+// Returns 0, or -1 if waiting kept failing.
+static int uring_drain(uring_t *ring, size_t n) {
+
+    unsigned long long tag;
+    int res;
+    int n_failed = 0;
+
+    while (n > 0) {
+        if (uring_wait(ring, &tag, &res) == 0) {
+            n--;
+            n_failed = 0;
+        }
+        else if (++n_failed == URING_DRAIN_RETRIES) {
+            return -1;
+        }
+        else {
+            usleep(1000); // Give the kernel a moment, the error may be temporary. (EAGAIN, EBUSY.)
+        }
+    }
+
+    return 0;
+}
+
+#endif /* HAVE_IO_URING */
+
+/* ---- READER ---- */
+
+// This is a struct for a buffer inside the ring.
+typedef struct slot {
+    char *data; // This is the buffer.
+    ssize_t len; // This is how many bytes were read into the buffer, or a negative errno.
+    int ready; // This is set when the read into the buffer has completed. (Only used with io_uring.)
+} slot_t;
+
+// This is the struct for the reader.
+// The buffers are used in order: buffer 'i % READER_NBUFS' holds the i-th block of the file.
+struct reader {
+    int fd; // This is the file being read.
+    pthread_t thread; // This is the reader thread.
+    pthread_mutex_t lock; // This protects every field below.
+    pthread_cond_t filled_cond; // This is signaled when a buffer is filled, or the end of the file is reached.
+    pthread_cond_t free_cond; // This is signaled when the caller is done with a buffer.
+    slot_t slots[READER_NBUFS]; // These are the buffers.
+    size_t n_filled; // This is how many buffers have been filled so far.
+    size_t n_consumed; // This is how many buffers the caller is done with so far.
+    int holding; // This is set while the caller holds buffer 'n_consumed'.
+    int eof; // This is set when the reader thread reached the end of the file.
+    int error; // This is set to the errno if reading failed.
+    int stop; // This is set when the reader should stop early.
+    int uring; // This is set if io_uring is used.
+    int in_flight; // This is set if reads could still be in flight when the reader thread ended, so the buffers are never freed.
+    off_t offset; // This is the file offset the next read starts at. (Only used with io_uring.)
+    off_t start; // This is the file offset the reader started at.
+    reader_stats_t stats; // This is the timing so far.
+    double t_open; // This is when the reader was opened.
+};
+
+// This is a function for the reader thread to wait until there is a free buffer.
+// Returns 0 if there is one, or -1 if the reader should stop. (Called with the lock held.)
+static int wait_free(reader_t *reader, size_t n_busy) {
+    while (n_busy - reader->n_consumed == READER_NBUFS && !reader->stop) {
+        pthread_cond_wait(&reader->free_cond, &reader->lock);
+    }
+    return reader->stop ? -1 : 0;
+}
+
+// This is a function to fill a buffer with 'read()', reading until the buffer is full or the file ends.
+static ssize_t read_full(int fd, char *buf, size_t len) {
+    size_t n = 0;
+
+    while (n < len) {
+        ssize_t rv = read(fd, buf + n, len - n);
+
+        if (rv < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (rv == 0) {
+            break;
+        }
+        n += rv;
+    }
+
+    return n;
+}
+
+// This is the reader thread when io_uring is not available, it fills the buffers one at a time with 'read()'.
+static void read_loop(reader_t *reader) {
+
+    pthread_mutex_lock(&reader->lock);
+
+    while (wait_free(reader, reader->n_filled) == 0) {
+        slot_t *slot = &reader->slots[reader->n_filled % READER_NBUFS];
+        pthread_mutex_unlock(&reader->lock);
+
+        double t0 = now();
+        slot->len = read_full(reader->fd, slot->data, READER_BUFSIZE);
+        double busy = now() - t0;
+
+        pthread_mutex_lock(&reader->lock);
+        reader->stats.read_s += busy;
+
+        if (slot->len < 0) {
+            reader->error = (int) -slot->len;
+            break;
+        }
+        if (slot->len == 0) {
+            reader->eof = 1;
+            break;
+        }
+
+        reader->n_filled++;
+        reader->stats.bytes += slot->len;
+        pthread_cond_signal(&reader->filled_cond);
+
+        // A short read means the end of the file was reached.
+        if (slot->len < READER_BUFSIZE) {
+            reader->eof = 1;
+            break;
+        }
+    }
+
+    pthread_cond_signal(&reader->filled_cond);
+    pthread_mutex_unlock(&reader->lock);
+}
+
+#ifdef HAVE_IO_URING
+
+// This is the reader thread with io_uring, it keeps a read in flight for every free buffer.
+static void uring_loop(reader_t *reader, uring_t *ring) {
+
+    size_t n_submitted = 0; // This is how many reads have been submitted.
+    size_t n_completed = 0; // This is how many reads have completed.
+    int done = 0; // This is set when no more reads should be submitted.
+
+    pthread_mutex_lock(&reader->lock);
+
+    while (1) {
+
+        // Submit a read for every free buffer.
+        while (!done && !reader->stop && n_submitted - reader->n_consumed < READER_NBUFS) {
+            slot_t *slot = &reader->slots[n_submitted % READER_NBUFS];
+            slot->ready = 0;
+            off_t offset = reader->offset;
+
+            // The submission enters the kernel, so the caller is not kept waiting for the lock meanwhile.
+            // (Only this thread touches the ring and the buffers that are not filled yet.)
+            pthread_mutex_unlock(&reader->lock);
+
+            // Reads from the page cache complete during the submission, so that counts as reading too.
+            double t0 = now();
+            int rv = uring_submit_read(ring, reader->fd, slot->data, READER_BUFSIZE, offset, n_submitted);
+            double busy = now() - t0;
+
+            pthread_mutex_lock(&reader->lock);
+            reader->stats.read_s += busy;
+
+            if (rv < 0) {
+                reader->error = errno ? errno : EIO;
+                done = 1;
+                break;
+            }
+
+            reader->offset += READER_BUFSIZE;
+            n_submitted++;
+        }
+
+        // Stop when every read has completed and no more will be submitted.
+        if (n_completed == n_submitted) {
+            if (done || reader->stop) {
+                break;
+            }
+            pthread_cond_wait(&reader->free_cond, &reader->lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&reader->lock);
+
+        unsigned long long tag;
+        int res;
+        double t0 = now();
+        int rv = uring_wait(ring, &tag, &res);
+        double busy = now() - t0;
+
+        // The tag is only set when waiting succeeded.
+        slot_t *slot = rv == 0 ? &reader->slots[tag % READER_NBUFS] : NULL;
+
+        // Finish a short read with 'pread()', so the blocks after it are still at the right offsets.
+        if (rv == 0 && res > 0 && res < READER_BUFSIZE) {
+            off_t offset = reader->start + (off_t) tag * READER_BUFSIZE;
+
+            while (res < READER_BUFSIZE) {
+                ssize_t n = pread(reader->fd, slot->data + res, READER_BUFSIZE - res, offset + res);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n < 0) {
+                    res = -errno;
+                }
+                if (n <= 0) {
+                    break;
+                }
+                res += n;
+            }
+        }
+
+        pthread_mutex_lock(&reader->lock);
+        reader->stats.read_s += busy;
+
+        if (rv < 0) {
+            reader->error = errno ? errno : EIO;
+            break;
+        }
+
+        n_completed++;
+        slot->len = res;
+        slot->ready = 1;
+
+        // The reads can complete out of order, so hand the buffers to the caller in file order.
+        while (!reader->eof && !reader->error && reader->n_filled < n_submitted) {
+            slot_t *next = &reader->slots[reader->n_filled % READER_NBUFS];
+
+            if (!next->ready) {
+                break;
+            }
+            if (next->len < 0) {
+                reader->error = (int) -next->len;
+                done = 1;
+                break;
+            }
+            if (next->len == 0) {
+                reader->eof = 1;
+                done = 1;
+                break;
+            }
+
+            reader->n_filled++;
+            reader->stats.bytes += next->len;
+
+            // A short read means the end of the file was reached.
+            if (next->len < READER_BUFSIZE) {
+                reader->eof = 1;
+                done = 1;
+            }
+        }
+
+        if (reader->stop) {
+            done = 1;
+        }
+
+        pthread_cond_signal(&reader->filled_cond);
+    }
+
+    pthread_cond_signal(&reader->filled_cond);
+    pthread_mutex_unlock(&reader->lock);
+
+    // If waiting failed, reads can still be in flight. Wait for them before the buffers can be freed.
+    if (n_completed < n_submitted && uring_drain(ring, n_submitted - n_completed) < 0) {
+        pthread_mutex_lock(&reader->lock);
+        reader->in_flight = 1;
+        pthread_mutex_unlock(&reader->lock);
+    }
+}
+
+#endif /* HAVE_IO_URING */
+
+// This is the function that the reader thread runs.
+static void *reader_main(void *arg) {
+    reader_t *reader = arg;
+
+#ifdef HAVE_IO_URING
+    uring_t ring;
+
+    if (reader->uring && uring_setup(&ring, READER_NBUFS) == 0) {
+        uring_loop(reader, &ring);
+        uring_teardown(&ring);
+        return NULL;
+    }
+
+    // Without io_uring, the reads start from the current offset of the file again.
+    reader->uring = 0;
+#endif
+
+    read_loop(reader);
+    return NULL;
+}
+
+// This is a function to start reading a file.
+reader_t *reader_open(int fd) {
+
+    reader_t *reader = calloc(1, sizeof(reader_t));
+    if (reader == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < READER_NBUFS; i++) {
+        reader->slots[i].data = malloc(READER_BUFSIZE);
+
+        if (reader->slots[i].data == NULL) {
+            for (size_t j = 0; j < i; j++) {
+                free(reader->slots[j].data);
+            }
+            free(reader);
+            return NULL;
+        }
+    }
+
+    reader->fd = fd;
+    reader->t_open = now();
+
+    // Tell the kernel the file is read from start to end, so it reads ahead more aggressively.
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // io_uring reads at explicit offsets, so it is only used for regular files, which have them.
+    struct stat st;
+    reader->start = lseek(fd, 0, SEEK_CUR);
+#ifdef HAVE_IO_URING
+    reader->uring = reader->start >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+#else
+    (void) st;
+#endif
+    reader->offset = reader->start;
+
+    pthread_mutex_init(&reader->lock, NULL);
+    pthread_cond_init(&reader->filled_cond, NULL);
+    pthread_cond_init(&reader->free_cond, NULL);
+
+    if (pthread_create(&reader->thread, NULL, reader_main, reader) != 0) {
+        pthread_mutex_destroy(&reader->lock);
+        pthread_cond_destroy(&reader->filled_cond);
+        pthread_cond_destroy(&reader->free_cond);
+        for (size_t i = 0; i < READER_NBUFS; i++) {
+            free(reader->slots[i].data);
+        }
+        free(reader);
+        return NULL;
+    }
+
+    return reader;
+}
+
+// This is a function to get the next filled buffer.
+ssize_t reader_next(reader_t *reader, const char **buf) {
+
+    double t0 = now();
+    pthread_mutex_lock(&reader->lock);
+
+    // Hand the previous buffer back to the reader thread.
+    if (reader->holding) {
+        reader->holding = 0;
+        reader->n_consumed++;
+        pthread_cond_signal(&reader->free_cond);
+    }
+
+    while (reader->n_filled == reader->n_consumed && !reader->eof && !reader->error) {
+        pthread_cond_wait(&reader->filled_cond, &reader->lock);
+    }
+
+    ssize_t len = 0;
+
+    // The buffers that were filled before an error or the end of the file are still handed out first.
+    if (reader->n_filled > reader->n_consumed) {
+        slot_t *slot = &reader->slots[reader->n_consumed % READER_NBUFS];
+        *buf = slot->data;
+        len = slot->len;
+        reader->holding = 1;
+        reader->stats.n_buffers++;
+    }
+    else if (reader->error) {
+        len = -1;
+    }
+
+    reader->stats.wait_s += now() - t0;
+    pthread_mutex_unlock(&reader->lock);
+
+    return len;
+}
+
+// This is a function to stop the reader and free it.
+int reader_close(reader_t *reader, reader_stats_t *stats) {
+
+    pthread_mutex_lock(&reader->lock);
+    reader->stop = 1;
+    pthread_cond_signal(&reader->free_cond);
+    pthread_mutex_unlock(&reader->lock);
+
+    pthread_join(reader->thread, NULL);
+
+    int rv = reader->error ? -1 : 0;
+
+    // io_uring does not move the file offset, so move it past what was handed out, like 'read()' would have.
+    if (reader->uring) {
+        lseek(reader->fd, reader->start + (off_t) reader->stats.bytes, SEEK_SET);
+    }
+
+    if (stats) {
+        *stats = reader->stats;
+        stats->uring = reader->uring;
+        stats->wall_s = now() - reader->t_open;
+    }
+
+    pthread_mutex_destroy(&reader->lock);
+    pthread_cond_destroy(&reader->filled_cond);
+    pthread_cond_destroy(&reader->free_cond);
+
+    // The buffers of reads that may still be in flight are never freed, since the kernel could still write into them.
+    for (size_t i = 0; i < READER_NBUFS && !reader->in_flight; i++) {
+        free(reader->slots[i].data);
+    }
+    free(reader);
+
+    return rv;
+}
+
+// This is a function to print the timing of a reader.
+// The caller computes whenever it is not waiting, so the time the reader thread was busy without the caller waiting
+// is the time that reading and computing overlapped.
+void reader_print_stats(FILE *out, reader_stats_t *stats) {
+
+    double compute_s = stats->wall_s - stats->wait_s;
+    double overlap_s = stats->read_s - stats->wait_s;
+
+    if (overlap_s < 0) {
+        overlap_s = 0;
+    }
+
+    fprintf(out, "--- I/O: %zu bytes in %zu buffers of %d KiB (%s) ---\n",
+        stats->bytes, stats->n_buffers, READER_BUFSIZE / 1024, stats->uring ? "io_uring" : "read");
+    fprintf(out, "Read: %.3f s | Compute: %.3f s | Wall: %.3f s | Overlap: %.3f s (%.0f%% of the read time hidden)\n",
+        stats->read_s, compute_s, stats->wall_s, overlap_s, stats->read_s > 0 ? 100.0 * overlap_s / stats->read_s : 100.0);
+}
@@ -0,0 +1,713 @@
+#include "server.h"
+#include "common.h"
+#include "ilist.h"
+#include "wordfreq.h"
+#include "wordtable.h"
+#include "prefixindex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// This is how many connections may wait to be accepted.
+#define LISTEN_BACKLOG 64
+
+// This is the size of the buffer a client connection reads responses into.
+#define CONN_BUFSIZE 0x10000
+
+// This is set by the signal handler when the server should stop.
+static volatile sig_atomic_t stop_requested = 0;
+
+// This is the signal handler for SIGINT and SIGTERM.
+static void request_stop(int sig) {
+    (void) sig;
+    stop_requested = 1;
+}
+
+/* ---- SERVER ---- */
+
+// This is a struct for a connected client.
+typedef struct client {
+    int fd; // This is the socket of the client.
+    char in[SERVER_MAX_LINE]; // This is the buffer for the request line that is being read.
+    size_t inlen; // This is how many bytes are inside the request buffer.
+    char *out; // This is the buffer for the responses that have not been sent yet.
+    size_t outlen; // This is how many bytes are inside the response buffer.
+    size_t outoff; // This is how many bytes of the response buffer have been sent.
+    size_t outcap; // This is the size of the response buffer.
+} client_t;
+
+// This is a function to add bytes to the response buffer of a client.
+static int client_append(client_t *client, const char *data, size_t len) {
+
+    // If the buffer is too small, double it until the data fits.
+    if (client->outlen + len > client->outcap) {
+        size_t cap = client->outcap ? client->outcap : 0x1000;
+
+        while (client->outlen + len > cap) {
+            cap *= 2;
+        }
+
+        char *out = realloc(client->out, cap);
+        if (out == NULL) {
+            return -1;
+        }
+
+        client->out = out;
+        client->outcap = cap;
+    }
+
+    memcpy(client->out + client->outlen, data, len);
+    client->outlen += len;
+    return 0;
+}
+
+// This is a function to add a formatted line to the response buffer of a client.
+static int client_printf(client_t *client, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static int client_printf(client_t *client, const char *fmt, ...) {
+    char line[SERVER_MAX_LINE + 64];
+
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    if (len < 0) {
+        return -1;
+    }
+    if ((size_t) len >= sizeof(line)) {
+        len = sizeof(line) - 1;
+    }
+    return client_append(client, line, len);
+}
+
+// This is a function to add one "<word>\t<count>" result line to the response buffer of a client.
+static int client_result(client_t *client, const word_freq_t *freq) {
+    char count[32];
+    int len = snprintf(count, sizeof(count), "\t%zu\n", freq->count);
+
+    if (client_append(client, word_freq_word(freq), freq->len) < 0) {
+        return -1;
+    }
+    return client_append(client, count, len);
+}
+
+// This is a function to answer a ranked query: at most 'lim' words (0 for all) that occur at least 'min_wc' times
+// and have at least 'min_wl' characters.
+static int answer_ranked(client_t *client, server_data_t *data, size_t min_wc, size_t min_wl, size_t lim) {
+
+    // The list is ranked by descending count, so the results are a prefix of it once short words are skipped.
+    // Count the results first, since the status line goes before them.
+    size_t n = 0;
+    ilist_foreach(link, data->freqs) {
+        word_freq_t *freq = ilist_entry(link, word_freq_t, link);
+
+        if (freq->count < min_wc || (lim && n >= lim)) {
+            break;
+        }
+        if (freq->len >= min_wl) {
+            n++;
+        }
+    }
+
+    if (client_printf(client, "OK %zu\n", n) < 0) {
+        return -1;
+    }
+
+    size_t n_sent = 0;
+    ilist_foreach(link, data->freqs) {
+        word_freq_t *freq = ilist_entry(link, word_freq_t, link);
+
+        if (n_sent == n) {
+            break;
+        }
+        if (freq->len >= min_wl) {
+            if (client_result(client, freq) < 0) {
+                return -1;
+            }
+            n_sent++;
+        }
+    }
+
+    return 0;
+}
+
+// This is a struct for a prefix query that is being answered, see 'answer_prefix'.
+typedef struct prefix_query {
+    client_t *client; // The results are added to the response buffer of this client.
+    size_t min_wc; // Stop at the first word that occurs less times than this.
+    size_t min_wl; // Skip the words shorter than this.
+    size_t lim; // Stop after this many results, or 0 for all.
+    size_t n; // This is how many results have been added.
+    int failed; // This is set if a result could not be added.
+} prefix_query_t;
+
+// This is a function to add one result of a prefix query to the response buffer.
+static int prefix_result(void *ctx, const char *word, size_t len, size_t count) {
+    prefix_query_t *query = ctx;
+
+    // The results come by descending count, so none of the rest occur often enough either.
+    if (count < query->min_wc) {
+        return 1;
+    }
+    if (len < query->min_wl) {
+        return 0;
+    }
+
+    char line[32];
+    int n = snprintf(line, sizeof(line), "\t%zu\n", count);
+
+    if (client_append(query->client, word, len) < 0 || client_append(query->client, line, n) < 0) {
+        query->failed = 1;
+        return 1;
+    }
+
+    query->n++;
+    return query->lim && query->n >= query->lim;
+}
+
+// This is a function to answer a prefix query: at most 'lim' words (0 for all) that start with 'prefix', by descending count.
+static int answer_prefix(client_t *client, prefixindex_t *prefixes, const char *prefix, size_t min_wc, size_t min_wl, size_t lim) {
+
+    // The number of results is only known once they have been added, so the status line is put in front of them afterwards.
+    size_t start = client->outlen;
+    prefix_query_t query = { client, min_wc, min_wl, lim, 0, 0 };
+
+    if (prefixindex_top(prefixes, prefix, strlen(prefix), prefix_result, &query) < 0 || query.failed) {
+        client->outlen = start;
+        return client_printf(client, "ERR out of memory\n");
+    }
+
+    char status[32];
+    int n = snprintf(status, sizeof(status), "OK %zu\n", query.n);
+    size_t results = client->outlen - start;
+
+    if (client_append(client, status, n) < 0) {
+        return -1;
+    }
+    memmove(client->out + start + n, client->out + start, results);
+    memcpy(client->out + start, status, n);
+    return 0;
+}
+
+// This is a function to parse up to 'max' unsigned numbers separated by spaces.
+// Returns how many numbers were parsed, or -1 if an argument is not a number.
+static int parse_numbers(char *s, size_t *values, int max) {
+    int n = 0;
+
+    for (char *tok = strtok(s, " \t"); tok != NULL; tok = strtok(NULL, " \t")) {
+        char *end;
+        errno = 0;
+        unsigned long long v = strtoull(tok, &end, 10);
+
+        if (n == max || errno || *end != 0 || tok[0] == '-') {
+            return -1;
+        }
+        values[n++] = (size_t) v;
+    }
+
+    return n;
+}
+
+// This is a function to answer one request line from a client.
+// Returns 1 if the client asked to close the connection, 0 if the request was answered, or -1 if it failed.
+static int answer(client_t *client, server_data_t *data, wordtable_t *index, prefixindex_t *prefixes, char *line) {
+
+    // Split the command from its arguments.
+    char *args = line + strcspn(line, " \t");
+    if (*args) {
+        *args++ = 0;
+    }
+
+    if (strcmp(line, "TOP") == 0) {
+        size_t v[3] = { data->lim_nres, data->min_wc, data->min_wl };
+
+        if (parse_numbers(args, v, 3) < 0) {
+            return client_printf(client, "ERR usage: TOP [k [min_wc [min_wl]]]\n");
+        }
+        return answer_ranked(client, data, v[1], v[2], v[0]);
+    }
+
+    if (strcmp(line, "FILTER") == 0) {
+        size_t v[3];
+
+        if (parse_numbers(args, v, 3) != 3) {
+            return client_printf(client, "ERR usage: FILTER min_wc min_wl lim\n");
+        }
+        return answer_ranked(client, data, v[0], v[1], v[2]);
+    }
+
+    if (strcmp(line, "GET") == 0) {
+
+        // Words are counted in lower case, so look them up in lower case too.
+        size_t len = strcspn(args, " \t");
+        if (len == 0 || args[len] != 0) {
+            return client_printf(client, "ERR usage: GET word\n");
+        }
+        for (size_t i = 0; i < len; i++) {
+            args[i] = tolower((unsigned char) args[i]);
+        }
+
+        word_freq_t *freq = wordtable_find(index, args, len, word_hash(args, len));
+        if (freq == NULL) {
+            return client_printf(client, "OK 0\n");
+        }
+        if (client_printf(client, "OK 1\n") < 0) {
+            return -1;
+        }
+        return client_result(client, freq);
+    }
+
+    if (strcmp(line, "PREFIX") == 0) {
+
+        // The prefix is the first argument, and the numbers after it are optional.
+        char *prefix = args;
+        char *rest = prefix + strcspn(prefix, " \t");
+        if (*rest) {
+            *rest++ = 0;
+        }
+
+        size_t v[3] = { data->lim_nres, data->min_wc, data->min_wl };
+        if (*prefix == 0 || parse_numbers(rest, v, 3) < 0) {
+            return client_printf(client, "ERR usage: PREFIX prefix [k [min_wc [min_wl]]]\n");
+        }
+        for (char *c = prefix; *c; c++) {
+            *c = tolower((unsigned char) *c);
+        }
+        return answer_prefix(client, prefixes, prefix, v[1], v[2], v[0]);
+    }
+
+    if (strcmp(line, "STATS") == 0) {
+        return client_printf(client, "OK 2\nwords\t%zu\ndistinct\t%zu\n", data->n_words, ilist_length(data->freqs));
+    }
+
+    if (strcmp(line, "QUIT") == 0) {
+        return 1;
+    }
+
+    return client_printf(client, "ERR unknown command\n");
+}
+
+// This is a function to read from a client and answer every complete request line.
+// Returns 1 if the connection should be closed, 0 if it stays open, or -1 if it failed.
+static int client_read(client_t *client, server_data_t *data, wordtable_t *index, prefixindex_t *prefixes) {
+
+    ssize_t n = read(client->fd, client->in + client->inlen, sizeof(client->in) - client->inlen);
+    if (n <= 0) {
+        return (n < 0 && errno == EINTR) ? 0 : 1;
+    }
+    client->inlen += n;
+
+    // Answer every complete line, and move what is left of the next line to the start of the buffer.
+    char *start = client->in;
+    char *end = client->in + client->inlen;
+    char *nl;
+
+    while ((nl = memchr(start, '\n', end - start)) != NULL) {
+        *nl = 0;
+        if (nl > start && nl[-1] == '\r') {
+            nl[-1] = 0;
+        }
+
+        int rv = answer(client, data, index, prefixes, start);
+        if (rv != 0) {
+            return rv;
+        }
+        start = nl + 1;
+    }
+
+    client->inlen = end - start;
+    memmove(client->in, start, client->inlen);
+
+    // A line that does not fit inside the buffer will never be complete.
+    if (client->inlen == sizeof(client->in)) {
+        client_printf(client, "ERR line too long\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+// This is a function to send as much of the response buffer of a client as the socket will take.
+// Returns 0 on success, or -1 if the connection failed.
+static int client_flush(client_t *client) {
+
+    while (client->outoff < client->outlen) {
+        ssize_t n = send(client->fd, client->out + client->outoff, client->outlen - client->outoff, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        client->outoff += n;
+    }
+
+    client->outlen = 0;
+    client->outoff = 0;
+    return 0;
+}
+
+// This is a function to close a client connection and free its buffers.
+static void client_close(client_t *client) {
+    close(client->fd);
+    free(client->out);
+    free(client);
+}
+
+// This is a function to create the listening socket, replacing a stale socket file left by an earlier server.
+static int listen_on(const char *sockpath) {
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (strlen(sockpath) >= sizeof(addr.sun_path)) {
+        printf("Error: The socket path \"%s\" is too long. \n", sockpath);
+        return -1;
+    }
+    strcpy(addr.sun_path, sockpath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        printf("Error: Failed to create a socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    // Only remove the path if it is a socket, never a regular file, and only if no server is listening on it anymore.
+    struct stat st;
+    if (stat(sockpath, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (probe >= 0 && connect(probe, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+            printf("Error: Another server is already listening on %s \n", sockpath);
+            close(probe);
+            close(fd);
+            return -1;
+        }
+
+        if (probe >= 0) {
+            close(probe);
+        }
+        unlink(sockpath);
+    }
+
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(fd, LISTEN_BACKLOG) < 0) {
+        printf("Error: Failed to listen on %s: %s\n", sockpath, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// This is a function to serve queries until SIGINT or SIGTERM.
+int serve_wordfreqs(const char *sockpath, server_data_t *data) {
+
+    int rv = -1;
+    client_t **clients = NULL;
+    struct pollfd *pfds = NULL;
+    size_t n_clients = 0;
+    size_t cap = 0;
+
+    // Index the words, so that GET does not have to walk the list.
+    wordtable_t index;
+    if (wordtable_init(&index, ilist_length(data->freqs)) < 0) {
+        printf("Error: Failed to allocate memory for the word index. \n");
+        return -1;
+    }
+
+    ilist_foreach(link, data->freqs) {
+        if (wordtable_insert(&index, ilist_entry(link, word_freq_t, link)) < 0) {
+            printf("Error: Failed to allocate memory for the word index. \n");
+            wordtable_destroy(&index);
+            return -1;
+        }
+    }
+
+    // Index the words by prefix too, for PREFIX.
+    prefixindex_t *prefixes = prefixindex_build(data->freqs, data->n_words);
+    if (prefixes == NULL) {
+        printf("Error: Failed to allocate memory for the prefix index. \n");
+        wordtable_destroy(&index);
+        return -1;
+    }
+
+    int lfd = listen_on(sockpath);
+    if (lfd < 0) {
+        prefixindex_destroy(prefixes);
+        wordtable_destroy(&index);
+        return -1;
+    }
+
+    // Stop on SIGINT and SIGTERM, without SA_RESTART so that 'poll' is interrupted.
+    // The actions from before are restored at the end.
+    struct sigaction sa, old_int, old_term;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = request_stop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+    stop_requested = 0;
+
+    printf("Serving %zu distinct words on %s \n", ilist_length(data->freqs), sockpath);
+    fflush(stdout);
+
+    while (!stop_requested) {
+
+        // Make room for the listening socket and every client.
+        if (n_clients + 1 > cap) {
+            size_t new_cap = cap ? cap * 2 : 16;
+            client_t **new_clients = realloc(clients, new_cap * sizeof(client_t *));
+            if (new_clients == NULL) {
+                printf("Error: Failed to allocate memory for the clients. \n");
+                goto cleanup;
+            }
+            clients = new_clients;
+
+            struct pollfd *new_pfds = realloc(pfds, (new_cap + 1) * sizeof(struct pollfd));
+            if (new_pfds == NULL) {
+                printf("Error: Failed to allocate memory for the clients. \n");
+                goto cleanup;
+            }
+            pfds = new_pfds;
+            cap = new_cap;
+        }
+
+        pfds[0].fd = lfd;
+        pfds[0].events = POLLIN;
+
+        // A client with unsent responses is not read from, so a slow reader can not make its buffer grow forever.
+        for (size_t i = 0; i < n_clients; i++) {
+            pfds[i + 1].fd = clients[i]->fd;
+            pfds[i + 1].events = clients[i]->outlen ? POLLOUT : POLLIN;
+        }
+
+        if (poll(pfds, n_clients + 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            printf("Error: Failed to wait for the clients: %s\n", strerror(errno));
+            goto cleanup;
+        }
+
+        // Handle the clients, and close the ones that are done. (Walk backwards, since closing moves the last client.)
+        for (size_t i = n_clients; i-- > 0;) {
+            client_t *client = clients[i];
+            short revents = pfds[i + 1].revents;
+            int done = 0;
+
+            if (revents & POLLOUT) {
+                done = client_flush(client) < 0;
+            }
+            else if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                done = client_read(client, data, &index, prefixes);
+
+                // Try to send the responses right away, most of them fit inside the socket buffer.
+                if (done == 0) {
+                    done = client_flush(client) < 0;
+                }
+                else if (done == 1) {
+                    client_flush(client);
+                }
+            }
+
+            if (done) {
+                client_close(client);
+                clients[i] = clients[--n_clients];
+            }
+        }
+
+        // Accept a new client.
+        if (pfds[0].revents & POLLIN) {
+            int fd = accept(lfd, NULL, NULL);
+
+            if (fd >= 0) {
+                client_t *client = calloc(1, sizeof(client_t));
+
+                if (client == NULL) {
+                    close(fd);
+                }
+                else {
+                    client->fd = fd;
+                    clients[n_clients++] = client;
+                }
+            }
+        }
+    }
+
+    rv = 0;
+
+cleanup:
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+
+    for (size_t i = 0; i < n_clients; i++) {
+        client_close(clients[i]);
+    }
+    free(clients);
+    free(pfds);
+
+    close(lfd);
+    unlink(sockpath);
+    prefixindex_destroy(prefixes);
+    wordtable_destroy(&index);
+
+    return rv;
+}
+
+/* ---- CLIENT ---- */
+
+// This is the struct for a client connection.
+struct server_conn {
+    int fd; // This is the socket connected to the server.
+    char buf[CONN_BUFSIZE]; // This is the buffer the responses are read into.
+    size_t start; // This is where the unread bytes inside the buffer start.
+    size_t end; // This is where the unread bytes inside the buffer end.
+};
+
+// This is a function to connect to the server.
+server_conn_t *server_connect(const char *sockpath) {
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (strlen(sockpath) >= sizeof(addr.sun_path)) {
+        return NULL;
+    }
+    strcpy(addr.sun_path, sockpath);
+
+    server_conn_t *conn = malloc(sizeof(server_conn_t));
+    if (conn == NULL) {
+        return NULL;
+    }
+
+    conn->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    conn->start = 0;
+    conn->end = 0;
+
+    if (conn->fd < 0 || connect(conn->fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        if (conn->fd >= 0) {
+            close(conn->fd);
+        }
+        free(conn);
+        return NULL;
+    }
+
+    return conn;
+}
+
+// This is a function to close a connection to the server.
+void server_disconnect(server_conn_t *conn) {
+    if (conn == NULL) {
+        return;
+    }
+    close(conn->fd);
+    free(conn);
+}
+
+// This is a function to read the next response line, the new line character is replaced with a null-terminator.
+// Returns a pointer to the line inside the buffer, or NULL if the connection failed.
+static char *conn_readline(server_conn_t *conn) {
+
+    while (1) {
+        char *nl = memchr(conn->buf + conn->start, '\n', conn->end - conn->start);
+
+        if (nl != NULL) {
+            char *line = conn->buf + conn->start;
+            *nl = 0;
+            conn->start = nl + 1 - conn->buf;
+            return line;
+        }
+
+        // Move the partial line to the start of the buffer, and read more after it.
+        memmove(conn->buf, conn->buf + conn->start, conn->end - conn->start);
+        conn->end -= conn->start;
+        conn->start = 0;
+
+        if (conn->end == sizeof(conn->buf)) {
+            return NULL;
+        }
+
+        ssize_t n = read(conn->fd, conn->buf + conn->end, sizeof(conn->buf) - conn->end);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return NULL;
+        }
+        conn->end += n;
+    }
+}
+
+// This is a function to send one request and read its response.
+long server_query(server_conn_t *conn, const char *request, FILE *out) {
+
+    size_t len = strlen(request);
+    char line[SERVER_MAX_LINE];
+
+    if (len + 1 > sizeof(line)) {
+        return -1;
+    }
+    memcpy(line, request, len);
+    line[len++] = '\n';
+
+    for (size_t off = 0; off < len;) {
+        ssize_t n = send(conn->fd, line + off, len - off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        off += n;
+    }
+
+    // "QUIT" has no response, the server just closes the connection.
+    if (strcmp(request, "QUIT") == 0) {
+        return 0;
+    }
+
+    char *status = conn_readline(conn);
+    if (status == NULL) {
+        return -1;
+    }
+
+    if (strncmp(status, "ERR", 3) == 0) {
+        if (out) {
+            fprintf(out, "%s\n", status);
+        }
+        return -2;
+    }
+
+    long n_lines;
+    if (sscanf(status, "OK %ld", &n_lines) != 1) {
+        return -1;
+    }
+
+    for (long i = 0; i < n_lines; i++) {
+        char *result = conn_readline(conn);
+        if (result == NULL) {
+            return -1;
+        }
+        if (out) {
+            fprintf(out, "%s\n", result);
+        }
+    }
+
+    return n_lines;
+}
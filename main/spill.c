@@ -0,0 +1,908 @@
+#include "spill.h"
+#include "common.h"
+#include "ilist.h"
+#include "reader.h"
+#include "wordfreq.h"
+#include "wordtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+// This is an estimate of what 'malloc' uses on top of each allocation.
+#define MALLOC_OVERHEAD 16
+
+// These are the smallest and the largest buffer used for writing or reading a run file.
+#define MIN_RUN_BUFSIZE 0x1000
+#define MAX_RUN_BUFSIZE 0x100000
+
+// This is how many file descriptors are left for everything else, such as the standard streams and the input file.
+#define RESERVED_FDS 8
+
+// This is how many levels of runs the open files are shared between. (Each level has fewer than 'fan-in' runs.)
+#define FD_LEVELS 4
+
+// Each record inside a run file is the length of the word, its count and then the word itself (without a null-terminator).
+#define RECORD_HEADER (sizeof(uint32_t) + sizeof(uint64_t))
+
+// This is a struct for a run file that is being read during a merge.
+typedef struct cursor {
+    int fd; // This is the run file.
+    char *buf; // This is the read buffer of the run file.
+    size_t bufsize; // This is the size of the read buffer.
+    size_t pos; // This is where the next record starts inside the read buffer.
+    size_t end; // This is where the bytes read into the buffer end.
+    const char *word; // This is the word of the current record.
+    size_t len; // This is the length of the word of the current record.
+    size_t count; // This is the count of the current record.
+} cursor_t;
+
+// This is a struct for a run file, and how many merges its records went through.
+typedef struct run {
+    int fd; // This is the run file. (It is unlinked, so it disappears when closed.)
+    size_t level; // This is 0 for a run written from memory, and one more than its inputs for a merged run.
+} run_t;
+
+// This is a struct for a set of runs, oldest (and biggest) first.
+typedef struct runs {
+    run_t *items; // These are the runs.
+    size_t length; // This is how many runs there are.
+    size_t capacity; // This is how many runs there is room for.
+    int ranked; // This is set if the records are sorted by rank, instead of by word.
+} runs_t;
+
+// This is a struct for writing records to a new run file through a buffer.
+typedef struct run_writer {
+    int fd; // This is the run file.
+    char *buf; // This is the write buffer.
+    size_t bufsize; // This is the size of the write buffer.
+    size_t n; // This is how many bytes are inside the write buffer.
+} run_writer_t;
+
+// This is the struct for the spill counter.
+struct spill {
+    size_t count_budget; // This is how many bytes the counts of the current run may use.
+    size_t io_budget; // This is how many bytes the buffers for writing and reading runs may use.
+    size_t fan_in; // This is the most runs that are merged at once.
+    char *tmpdir; // This is the directory for the run files.
+    wordtable_t table; // This indexes the records of the current run by word.
+    ilist_t records; // These are the records of the current run, and after 'spill_finish' the results kept in memory.
+    size_t used; // This is an estimate of how many bytes the records inside 'records' use.
+    size_t n_words; // This is how many words have been counted.
+    size_t n_files; // This is how many run files were written.
+    runs_t runs; // These are the runs of counts, sorted by word.
+    runs_t ranked; // These are the runs of results, sorted by rank, if the results did not fit inside the budget.
+};
+
+// This is a struct for the results while the runs are merged, see 'add_result'.
+typedef struct results {
+    spill_t *spill; // This is the spill counter.
+    size_t min_wc; // Skip the words that occur less times than this.
+    size_t lim_nres; // This is the size of 'top', or 0 if every result is kept.
+    word_freq_t **top; // This is a min-heap of the best records so far, if the results are limited.
+    size_t n_top; // This is how many records are inside 'top'.
+    size_t n_distinct; // This is how many distinct words were merged.
+} results_t;
+
+// This is a function to estimate how many bytes a record for a word of the given length uses.
+static size_t record_cost(size_t len) {
+    size_t cost = sizeof(word_freq_t) + MALLOC_OVERHEAD;
+
+    if (len >= WORD_FREQ_INLINE) {
+        cost += len + 1 + MALLOC_OVERHEAD;
+    }
+    return cost;
+}
+
+// This is a function to get the size of each of 'n' buffers that share 'budget' bytes.
+static size_t buffer_size(size_t budget, size_t n) {
+    size_t bufsize = budget / (n ? n : 1);
+    return bufsize < MIN_RUN_BUFSIZE ? MIN_RUN_BUFSIZE : bufsize > MAX_RUN_BUFSIZE ? MAX_RUN_BUFSIZE : bufsize;
+}
+
+// This is a function to create a spill counter.
+spill_t *spill_create(size_t max_memory, const char *tmpdir) {
+
+    // The reader and the output buffers are allocated no matter what, so they are taken from the budget first,
+    // along with the rest of the program.
+    size_t fixed = READER_NBUFS * READER_BUFSIZE + OUTBUF_SIZE + SPILL_BASE_MEMORY;
+    if (max_memory < SPILL_MIN_MEMORY) {
+        max_memory = SPILL_MIN_MEMORY;
+    }
+
+    spill_t *spill = calloc(1, sizeof(spill_t));
+    if (spill == NULL) {
+        return NULL;
+    }
+
+    // Give three quarters of what is left to the counts, and the rest to the buffers for the run files.
+    spill->count_budget = (max_memory - fixed) / 4 * 3;
+    spill->io_budget = (max_memory - fixed) / 4;
+    spill->tmpdir = strdup(tmpdir);
+    spill->ranked.ranked = 1;
+    ilist_init(&spill->records);
+
+    // Each run that is merged needs a buffer and an open file, plus one of each for the merged run.
+    // The results may be written while the runs are merged, so each side gets half of the buffer budget.
+    size_t fan_in = spill->io_budget / 2 / MIN_RUN_BUFSIZE - 1;
+    if (fan_in > SPILL_MAX_FAN_IN) {
+        fan_in = SPILL_MAX_FAN_IN;
+    }
+
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) {
+        size_t by_files = rl.rlim_cur > RESERVED_FDS ? (rl.rlim_cur - RESERVED_FDS) / FD_LEVELS : 0;
+        if (fan_in > by_files) {
+            fan_in = by_files;
+        }
+    }
+    spill->fan_in = fan_in < 2 ? 2 : fan_in;
+
+    if (spill->tmpdir == NULL || wordtable_init(&spill->table, 0) < 0) {
+        free(spill->tmpdir);
+        free(spill);
+        return NULL;
+    }
+
+    return spill;
+}
+
+// This is a function to write all of 'len' bytes to a file.
+static int write_all(int fd, const char *data, size_t len) {
+
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+// This is a function to create a new run file with a write buffer of 'bufsize' bytes. Returns 0, or -1 on failure.
+static int writer_open(spill_t *spill, run_writer_t *writer, size_t bufsize) {
+
+    // Create the run file, and unlink it right away so it is removed however the program ends.
+    size_t pathlen = strlen(spill->tmpdir) + sizeof("/wordfrequency-run-XXXXXX");
+    char *path = malloc(pathlen);
+    if (path == NULL) {
+        printf("Error: Failed to allocate memory for the run file path. \n");
+        return -1;
+    }
+    snprintf(path, pathlen, "%s/wordfrequency-run-XXXXXX", spill->tmpdir);
+
+    writer->fd = mkstemp(path);
+    if (writer->fd < 0) {
+        printf("Error: Failed to create a run file inside %s: %s\n", spill->tmpdir, strerror(errno));
+        free(path);
+        return -1;
+    }
+    unlink(path);
+    free(path);
+
+    writer->bufsize = bufsize;
+    writer->n = 0;
+    writer->buf = malloc(bufsize);
+    if (writer->buf == NULL) {
+        printf("Error: Failed to allocate memory for writing a run file. \n");
+        close(writer->fd);
+        return -1;
+    }
+
+    spill->n_files++;
+    return 0;
+}
+
+// This is a function to add a record to a run file, it is a 'spill_result_fn'. Returns 0, or -1 if writing failed.
+static int writer_add(void *ctx, const char *word, size_t len, size_t count) {
+
+    run_writer_t *writer = ctx;
+    uint32_t len32 = (uint32_t) len;
+    uint64_t count64 = count;
+
+    // Flush the buffer when the next record does not fit, a record longer than the buffer is written on its own.
+    if (writer->n + RECORD_HEADER + len > writer->bufsize) {
+        if (write_all(writer->fd, writer->buf, writer->n) < 0) {
+            return -1;
+        }
+        writer->n = 0;
+    }
+
+    memcpy(writer->buf + writer->n, &len32, sizeof(len32));
+    memcpy(writer->buf + writer->n + sizeof(len32), &count64, sizeof(count64));
+    writer->n += RECORD_HEADER;
+
+    if (writer->n + len > writer->bufsize) {
+        if (write_all(writer->fd, writer->buf, writer->n) < 0 || write_all(writer->fd, word, len) < 0) {
+            return -1;
+        }
+        writer->n = 0;
+    }
+    else {
+        memcpy(writer->buf + writer->n, word, len);
+        writer->n += len;
+    }
+
+    return 0;
+}
+
+// This is a function to write the rest of the buffer and free it. Returns the run file, or -1 if writing failed.
+static int writer_close(run_writer_t *writer, int failed) {
+
+    if (!failed && writer->n > 0 && write_all(writer->fd, writer->buf, writer->n) < 0) {
+        failed = 1;
+    }
+    free(writer->buf);
+    writer->buf = NULL;
+
+    if (failed) {
+        printf("Error: Failed to write a run file: %s\n", strerror(errno));
+        close(writer->fd);
+        return -1;
+    }
+
+    return writer->fd;
+}
+
+// This is a function to open a cursor with a read buffer of 'bufsize' bytes on each of 'n' runs.
+// Returns the cursors, or NULL if memory could not be allocated.
+static cursor_t *open_cursors(const run_t *items, size_t n, size_t bufsize) {
+
+    cursor_t *cursors = calloc(n, sizeof(cursor_t));
+    if (cursors == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        cursors[i].fd = items[i].fd;
+        cursors[i].bufsize = bufsize;
+        cursors[i].buf = malloc(bufsize);
+
+        if (cursors[i].buf == NULL || lseek(cursors[i].fd, 0, SEEK_SET) < 0) {
+            for (size_t j = 0; j <= i; j++) {
+                free(cursors[j].buf);
+            }
+            free(cursors);
+            return NULL;
+        }
+    }
+
+    return cursors;
+}
+
+// This is a function to free the buffers of the cursors. (The run files stay open.)
+static void close_cursors(cursor_t *cursors, size_t n) {
+
+    for (size_t i = 0; i < n; i++) {
+        free(cursors[i].buf);
+    }
+    free(cursors);
+}
+
+// This is a function to move the cursor to the next record. Returns 1 if there is one, 0 at the end, or -1 on failure.
+static int cursor_next(cursor_t *cur) {
+
+    uint32_t len = 0;
+    int have_header = 0;
+
+    // Read until the whole next record is inside the buffer.
+    while (1) {
+        size_t avail = cur->end - cur->pos;
+
+        if (!have_header && avail >= RECORD_HEADER) {
+            memcpy(&len, cur->buf + cur->pos, sizeof(len));
+            have_header = 1;
+
+            // Make the buffer bigger if a record does not fit inside it.
+            if (RECORD_HEADER + len > cur->bufsize) {
+                char *buf = malloc(RECORD_HEADER + len);
+                if (buf == NULL) {
+                    return -1;
+                }
+                memcpy(buf, cur->buf + cur->pos, avail);
+                free(cur->buf);
+                cur->buf = buf;
+                cur->bufsize = RECORD_HEADER + len;
+                cur->pos = 0;
+                cur->end = avail;
+            }
+        }
+
+        if (have_header && avail >= RECORD_HEADER + len) {
+            break;
+        }
+
+        // Move the partial record to the start of the buffer and read more after it.
+        memmove(cur->buf, cur->buf + cur->pos, avail);
+        cur->pos = 0;
+        cur->end = avail;
+
+        ssize_t n = read(cur->fd, cur->buf + cur->end, cur->bufsize - cur->end);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            return avail == 0 ? 0 : -1; // A partial record at the end means the run file is broken.
+        }
+        cur->end += n;
+    }
+
+    uint64_t count;
+    memcpy(&count, cur->buf + cur->pos + sizeof(len), sizeof(count));
+
+    cur->word = cur->buf + cur->pos + RECORD_HEADER;
+    cur->len = len;
+    cur->count = count;
+    cur->pos += RECORD_HEADER + len;
+    return 1;
+}
+
+// This is a function to compare the current records of two cursors, by word or by rank.
+static int cursor_cmp(const cursor_t *a, const cursor_t *b, int ranked) {
+
+    // A higher count ranks first.
+    if (ranked && a->count != b->count) {
+        return a->count > b->count ? -1 : 1;
+    }
+
+    size_t len = a->len < b->len ? a->len : b->len;
+    int rv = memcmp(a->word, b->word, len);
+
+    if (rv != 0) {
+        return rv;
+    }
+    return (a->len > b->len) - (a->len < b->len);
+}
+
+// This is a function to move the cursor at 'i' down the heap until both of its children have greater records.
+static void cursor_siftdown(cursor_t **heap, size_t n, size_t i, int ranked) {
+
+    while (1) {
+        size_t min = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+
+        if (left < n && cursor_cmp(heap[left], heap[min], ranked) < 0) {
+            min = left;
+        }
+        if (right < n && cursor_cmp(heap[right], heap[min], ranked) < 0) {
+            min = right;
+        }
+        if (min == i) {
+            return;
+        }
+
+        cursor_t *temp = heap[i];
+        heap[i] = heap[min];
+        heap[min] = temp;
+        i = min;
+    }
+}
+
+// This is a function to merge the records of 'n' cursors (k-way), and call 'emit' with each of them in order.
+// In word order, the counts of a word from every run are added up first. In rank order, every word is inside one run.
+// Returns 0, the non-zero value that 'emit' returned to stop, or -1 if a run file could not be read.
+static int merge_cursors(cursor_t *cursors, size_t n, int ranked, spill_result_fn emit, void *ctx) {
+
+    int rv = 0;
+    cursor_t **heap = malloc(n * sizeof(cursor_t *));
+    char *word = NULL; // This is the word that is being merged.
+    size_t wordcap = 0;
+    size_t n_heap = 0;
+
+    if (heap == NULL) {
+        printf("Error: Failed to allocate memory for merging the runs. \n");
+        return -1;
+    }
+
+    // Start the heap with the first record of every run.
+    for (size_t i = 0; i < n; i++) {
+        int more = cursor_next(&cursors[i]);
+
+        if (more < 0) {
+            printf("Error: Failed to read a run file. \n");
+            rv = -1;
+            goto cleanup;
+        }
+        if (more) {
+            heap[n_heap++] = &cursors[i];
+        }
+    }
+    for (size_t i = n_heap / 2; i-- > 0;) {
+        cursor_siftdown(heap, n_heap, i, ranked);
+    }
+
+    while (n_heap > 0 && rv == 0) {
+        size_t len = heap[0]->len;
+        size_t count = 0;
+
+        if (ranked) {
+            rv = emit(ctx, heap[0]->word, len, heap[0]->count);
+        }
+        else {
+            // Copy the smallest word, since the cursor moves on.
+            if (len + 1 > wordcap) {
+                char *re_word = realloc(word, len + 1);
+                if (re_word == NULL) {
+                    printf("Error: Failed to allocate memory for merging the runs. \n");
+                    rv = -1;
+                    goto cleanup;
+                }
+                word = re_word;
+                wordcap = len + 1;
+            }
+            memcpy(word, heap[0]->word, len);
+            word[len] = 0;
+        }
+
+        // Move on from this word in every run that has it, they are all at the top of the heap.
+        do {
+            count += heap[0]->count;
+
+            int more = cursor_next(heap[0]);
+            if (more < 0) {
+                printf("Error: Failed to read a run file. \n");
+                rv = -1;
+                goto cleanup;
+            }
+            if (!more) {
+                heap[0] = heap[--n_heap];
+            }
+            cursor_siftdown(heap, n_heap, 0, ranked);
+        } while (!ranked && n_heap > 0 && heap[0]->len == len && memcmp(heap[0]->word, word, len) == 0);
+
+        if (!ranked && rv == 0) {
+            rv = emit(ctx, word, len, count);
+        }
+    }
+
+cleanup:
+    free(heap);
+    free(word);
+    return rv;
+}
+
+// This is a function to merge 'n' runs starting at 'first' into one new run, with 'budget' bytes for the buffers.
+static int merge_runs(spill_t *spill, runs_t *runs, size_t first, size_t n, size_t budget) {
+
+    // Every input and the output get a buffer.
+    size_t bufsize = buffer_size(budget, n + 1);
+    cursor_t *cursors = open_cursors(runs->items + first, n, bufsize);
+    if (cursors == NULL) {
+        printf("Error: Failed to prepare the run files for merging. \n");
+        return -1;
+    }
+
+    run_writer_t writer;
+    if (writer_open(spill, &writer, bufsize) < 0) {
+        close_cursors(cursors, n);
+        return -1;
+    }
+
+    int rv = merge_cursors(cursors, n, runs->ranked, writer_add, &writer);
+    int fd = writer_close(&writer, rv != 0);
+    close_cursors(cursors, n);
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    // Replace the inputs with the merged run.
+    size_t level = 0;
+    for (size_t i = first; i < first + n; i++) {
+        level = runs->items[i].level > level ? runs->items[i].level : level;
+        close(runs->items[i].fd);
+    }
+
+    runs->items[first].fd = fd;
+    runs->items[first].level = level + 1;
+    memmove(runs->items + first + 1, runs->items + first + n, (runs->length - first - n) * sizeof(run_t));
+    runs->length -= n - 1;
+    return 0;
+}
+
+// This is a function to add a new run to a set of runs, with 'budget' bytes for the buffers of any merge it leads to.
+// Once the last 'fan-in' runs are of the same level, they are merged into one run of the next level, like a counter
+// that carries over, so there are fewer than 'fan-in' runs of each level and every record is merged about log(n) times.
+static int add_run(spill_t *spill, runs_t *runs, int fd, size_t budget) {
+
+    if (runs->length == runs->capacity) {
+        size_t cap = runs->capacity ? runs->capacity * 2 : 16;
+        run_t *items = realloc(runs->items, cap * sizeof(run_t));
+
+        if (items == NULL) {
+            printf("Error: Failed to allocate memory for the run files. \n");
+            close(fd);
+            return -1;
+        }
+        runs->items = items;
+        runs->capacity = cap;
+    }
+
+    runs->items[runs->length].fd = fd;
+    runs->items[runs->length].level = 0;
+    runs->length++;
+
+    // The levels only go down from the oldest run to the newest, so the first and the last of them tell if they are equal.
+    while (runs->length >= spill->fan_in) {
+        size_t first = runs->length - spill->fan_in;
+
+        if (runs->items[first].level != runs->items[runs->length - 1].level) {
+            break;
+        }
+        if (merge_runs(spill, runs, first, spill->fan_in, budget) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// This is a function to write the sorted records of 'list' to a new run, free them, and add the run to 'runs'.
+static int write_run(spill_t *spill, runs_t *runs, ilist_t *list, size_t budget) {
+
+    run_writer_t writer;
+    if (writer_open(spill, &writer, buffer_size(budget, 1)) < 0) {
+        return -1;
+    }
+
+    int failed = 0;
+    ilist_foreach(link, list) {
+        word_freq_t *freq = ilist_entry(link, word_freq_t, link);
+
+        if (writer_add(&writer, word_freq_word(freq), freq->len, freq->count) < 0) {
+            failed = 1;
+            break;
+        }
+    }
+
+    int fd = writer_close(&writer, failed);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // Free the records before the run is added, so a merge it leads to has the memory.
+    ilist_destroy(list, word_freq_free);
+    spill->used = 0;
+
+    return add_run(spill, runs, fd, budget);
+}
+
+// This is a function to sort the records of the current run by word, write them to a new run file and free them.
+static int spill_run(spill_t *spill) {
+
+    // Sort the records by word. (Mergesort on the links themselves, so no extra memory is needed.)
+    ilist_sort(&spill->records, compare_word_freq_by_word);
+
+    size_t n_records = spill->table.length;
+    wordtable_destroy(&spill->table);
+
+    if (write_run(spill, &spill->runs, &spill->records, spill->io_budget) < 0) {
+        return -1;
+    }
+
+    // Start the next run with an empty table.
+    if (wordtable_init(&spill->table, n_records / 2) < 0) {
+        printf("Error: Failed to allocate memory for the word table. \n");
+        return -1;
+    }
+
+    return 0;
+}
+
+// This is a function to count one word.
+int spill_add(void *ctx, const char *word, size_t len) {
+
+    spill_t *spill = ctx;
+    uint32_t hash = word_hash(word, len);
+
+    spill->n_words++;
+
+    word_freq_t *freq = wordtable_find(&spill->table, word, len, hash);
+    if (freq != NULL) {
+        freq->count++;
+        return 0;
+    }
+
+    // While the table grows, the old and the new slots are both allocated.
+    size_t slots = spill->table.capacity * sizeof(word_freq_t *);
+    if (2 * (spill->table.length + 1) > spill->table.capacity) {
+        slots *= 3;
+    }
+
+    // Spill the current run first if the new word would not fit inside the budget.
+    if (spill->table.length > 0 && spill->used + record_cost(len) + slots > spill->count_budget) {
+        if (spill_run(spill) < 0) {
+            return -1;
+        }
+    }
+
+    freq = word_freq_create(word, len, 1);
+    if (freq == NULL || wordtable_insert(&spill->table, freq) < 0) {
+        printf("Error: Failed to allocate memory for counting a word. \n");
+        if (freq) {
+            word_freq_free(&freq->link);
+        }
+        return -1;
+    }
+
+    ilist_addlast(&spill->records, &freq->link);
+    spill->used += record_cost(len);
+    return 0;
+}
+
+// This is a function to check if record 'a' ranks below record 'b': it has a lower count, or the same count and a later word.
+static int freq_worse(const word_freq_t *a, const word_freq_t *b) {
+    if (a->count != b->count) {
+        return a->count < b->count;
+    }
+    return compare_word_freq_by_word(&a->link, &b->link) > 0;
+}
+
+// This is a function to sort the records by rank: the highest count first, and the same counts in alphabetical order.
+static int compare_rank(const ilink_t *la, const ilink_t *lb) {
+    const word_freq_t *a = ilist_entry(la, word_freq_t, link);
+    const word_freq_t *b = ilist_entry(lb, word_freq_t, link);
+
+    return freq_worse(a, b) - freq_worse(b, a);
+}
+
+// This is a function to move the record at 'i' down the heap until both of its children rank above it.
+static void freq_siftdown(word_freq_t **heap, size_t n, size_t i) {
+
+    while (1) {
+        size_t min = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+
+        if (left < n && freq_worse(heap[left], heap[min])) {
+            min = left;
+        }
+        if (right < n && freq_worse(heap[right], heap[min])) {
+            min = right;
+        }
+        if (min == i) {
+            return;
+        }
+
+        word_freq_t *temp = heap[i];
+        heap[i] = heap[min];
+        heap[min] = temp;
+        i = min;
+    }
+}
+
+// This is a function to take the next merged word, it is the 'spill_result_fn' for the final merge.
+// The words arrive in alphabetical order. Returns 0, or -1 on failure.
+static int add_result(void *ctx, const char *word, size_t len, size_t count) {
+
+    results_t *res = ctx;
+    spill_t *spill = res->spill;
+
+    res->n_distinct++;
+
+    if (count < res->min_wc) {
+        return 0;
+    }
+
+    // When the results are limited, a word with the same count as the worst one kept so far would rank below it,
+    // so only a greater count can replace it.
+    if (res->lim_nres && res->n_top == res->lim_nres && count <= res->top[0]->count) {
+        return 0;
+    }
+
+    word_freq_t *freq = word_freq_create(word, len, count);
+    if (freq == NULL) {
+        printf("Error: Cannot allocate memory for a new word-frequency pair. \n");
+        return -1;
+    }
+
+    if (res->lim_nres == 0) {
+        ilist_addlast(&spill->records, &freq->link);
+        spill->used += record_cost(len);
+
+        // When the results outgrow the budget, they are ranked and written to a run of their own.
+        // The merge of the runs of counts has the other half of the buffer budget.
+        if (spill->used > spill->count_budget) {
+            ilist_sort(&spill->records, compare_rank);
+            return write_run(spill, &spill->ranked, &spill->records, spill->io_budget / 2);
+        }
+    }
+    else if (res->n_top < res->lim_nres) {
+        res->top[res->n_top++] = freq;
+
+        if (res->n_top == res->lim_nres) {
+            for (size_t i = res->n_top / 2; i-- > 0;) {
+                freq_siftdown(res->top, res->n_top, i);
+            }
+        }
+    }
+    else {
+        word_freq_free(&res->top[0]->link);
+        res->top[0] = freq;
+        freq_siftdown(res->top, res->n_top, 0);
+    }
+
+    return 0;
+}
+
+// This is a function to merge every run into the final counts.
+int spill_finish(spill_t *spill, size_t min_wc, size_t lim_nres, size_t *n_words, size_t *n_distinct) {
+
+    *n_words = spill->n_words;
+    *n_distinct = 0;
+    wordtable_destroy(&spill->table);
+
+    // If nothing was spilled, the records of the current run are the final counts already.
+    if (spill->runs.length == 0) {
+        *n_distinct = ilist_length(&spill->records);
+
+        ilink_t *link = spill->records.head;
+        while (link) {
+            ilink_t *next = link->next;
+
+            if (ilist_entry(link, word_freq_t, link)->count < min_wc) {
+                ilist_remove(&spill->records, link);
+                word_freq_free(link);
+            }
+            link = next;
+        }
+
+        ilist_sort(&spill->records, compare_rank);
+        return 0;
+    }
+
+    // Otherwise the current run is written out too, so the whole budget is free for the results.
+    if (spill_run(spill) < 0) {
+        return -1;
+    }
+    wordtable_destroy(&spill->table);
+
+    // Merge down to at most 'fan-in' runs, the newest (and smallest) ones first.
+    while (spill->runs.length > spill->fan_in) {
+        if (merge_runs(spill, &spill->runs, spill->runs.length - spill->fan_in, spill->fan_in, spill->io_budget) < 0) {
+            return -1;
+        }
+    }
+
+    // A limited number of results is kept in a heap, if that fits inside the budget.
+    results_t res = { spill, min_wc, 0, NULL, 0, 0 };
+    if (lim_nres && lim_nres <= spill->count_budget / (record_cost(WORD_FREQ_INLINE) + sizeof(word_freq_t *))) {
+        res.lim_nres = lim_nres;
+        res.top = malloc(lim_nres * sizeof(word_freq_t *));
+
+        if (res.top == NULL) {
+            printf("Error: Failed to allocate memory for the results. \n");
+            return -1;
+        }
+    }
+
+    int rv = -1;
+    size_t n_runs = spill->runs.length;
+    cursor_t *cursors = open_cursors(spill->runs.items, n_runs, buffer_size(spill->io_budget / 2, n_runs));
+
+    if (cursors == NULL) {
+        printf("Error: Failed to prepare the run files for merging. \n");
+        goto cleanup;
+    }
+
+    rv = merge_cursors(cursors, n_runs, 0, add_result, &res);
+    close_cursors(cursors, n_runs);
+
+    if (rv != 0) {
+        rv = -1;
+        goto cleanup;
+    }
+
+    // The runs of counts are not needed anymore.
+    for (size_t i = 0; i < n_runs; i++) {
+        close(spill->runs.items[i].fd);
+    }
+    spill->runs.length = 0;
+
+    *n_distinct = res.n_distinct;
+
+    // The results kept in memory are ranked where they are, unless some of them were written out already.
+    for (size_t i = 0; i < res.n_top; i++) {
+        ilist_addlast(&spill->records, &res.top[i]->link);
+    }
+    res.n_top = 0;
+
+    ilist_sort(&spill->records, compare_rank);
+
+    if (spill->ranked.length > 0) {
+        if (write_run(spill, &spill->ranked, &spill->records, spill->io_budget) < 0) {
+            rv = -1;
+            goto cleanup;
+        }
+
+        while (spill->ranked.length > spill->fan_in) {
+            if (merge_runs(spill, &spill->ranked, spill->ranked.length - spill->fan_in, spill->fan_in, spill->io_budget) < 0) {
+                rv = -1;
+                goto cleanup;
+            }
+        }
+    }
+
+cleanup:
+    for (size_t i = 0; i < res.n_top; i++) {
+        word_freq_free(&res.top[i]->link);
+    }
+    free(res.top);
+
+    if (rv < 0) {
+        ilist_destroy(&spill->records, word_freq_free);
+    }
+
+    return rv;
+}
+
+// This is a function to call 'result' with each result, in ranked order.
+int spill_results(spill_t *spill, spill_result_fn result, void *ctx) {
+
+    // The results that fit inside the budget are in memory.
+    if (spill->ranked.length == 0) {
+        ilist_foreach(link, &spill->records) {
+            word_freq_t *freq = ilist_entry(link, word_freq_t, link);
+
+            if (result(ctx, word_freq_word(freq), freq->len, freq->count)) {
+                break;
+            }
+        }
+        return 0;
+    }
+
+    // Otherwise they are merged from the ranked runs as they are asked for.
+    size_t n_runs = spill->ranked.length;
+    cursor_t *cursors = open_cursors(spill->ranked.items, n_runs, buffer_size(spill->io_budget, n_runs));
+
+    if (cursors == NULL) {
+        printf("Error: Failed to prepare the run files for merging. \n");
+        return -1;
+    }
+
+    int rv = merge_cursors(cursors, n_runs, 1, result, ctx);
+    close_cursors(cursors, n_runs);
+
+    return rv < 0 ? -1 : 0;
+}
+
+// This is a function to get how many run files were written.
+size_t spill_nruns(spill_t *spill) {
+    return spill->n_files;
+}
+
+// This is a function to close every run file and free the spill counter.
+void spill_destroy(spill_t *spill) {
+
+    if (spill == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < spill->runs.length; i++) {
+        close(spill->runs.items[i].fd);
+    }
+    for (size_t i = 0; i < spill->ranked.length; i++) {
+        close(spill->ranked.items[i].fd);
+    }
+    free(spill->runs.items);
+    free(spill->ranked.items);
+
+    ilist_destroy(&spill->records, word_freq_free);
+    wordtable_destroy(&spill->table);
+    free(spill->tmpdir);
+    free(spill);
+}
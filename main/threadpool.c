@@ -0,0 +1,164 @@
+#include "threadpool.h"
+#include "common.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// This is the struct for the thread pool.
+struct threadpool {
+    pthread_mutex_t lock; // This protects every field below.
+    pthread_cond_t work; // This is signaled when a loop starts, or when the pool is stopped.
+    pthread_cond_t done; // This is signaled when the last task of a loop finishes.
+    pthread_mutex_t run_lock; // This lets only one loop run at a time.
+    pthread_t *threads; // These are the worker threads.
+    size_t n_workers; // This is how many worker threads there are.
+    task_fn fn; // This is the task function of the current loop.
+    void *ctx; // This is passed to 'fn'.
+    size_t n_tasks; // This is how many tasks the current loop has.
+    size_t next; // This is the next task to hand out.
+    size_t n_done; // This is how many tasks have finished.
+    int stop; // This is set when the pool is destroyed.
+};
+
+// This is a function to run tasks of the current loop until there are none left. (The lock must be held.)
+static void run_tasks(threadpool_t *pool) {
+
+    while (pool->next < pool->n_tasks) {
+        size_t task = pool->next++;
+        task_fn fn = pool->fn;
+        void *ctx = pool->ctx;
+
+        pthread_mutex_unlock(&pool->lock);
+        fn(ctx, task);
+        pthread_mutex_lock(&pool->lock);
+
+        if (++pool->n_done == pool->n_tasks) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+}
+
+// This is the function that the worker threads run.
+static void *worker(void *arg) {
+    threadpool_t *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (!pool->stop) {
+        run_tasks(pool);
+
+        // Sleep until the next loop starts. (Or the pool is stopped.)
+        while (!pool->stop && pool->next >= pool->n_tasks) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// This is a function to create a pool with 'n_workers' threads besides the calling thread.
+threadpool_t *threadpool_create(size_t n_workers) {
+
+    threadpool_t *pool = calloc(1, sizeof(threadpool_t));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->threads = calloc(n_workers ? n_workers : 1, sizeof(pthread_t));
+    if (pool->threads == NULL) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (size_t i = 0; i < n_workers; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker, pool) != 0) {
+            threadpool_destroy(pool);
+            return NULL;
+        }
+        pool->n_workers++;
+    }
+
+    return pool;
+}
+
+// This is a function to get how many threads run tasks.
+size_t threadpool_size(threadpool_t *pool) {
+    return pool->n_workers + 1;
+}
+
+// This is a function to run a loop of 'n_tasks' tasks on the pool.
+void threadpool_run(threadpool_t *pool, size_t n_tasks, task_fn fn, void *ctx) {
+
+    if (n_tasks == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->run_lock);
+    pthread_mutex_lock(&pool->lock);
+
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->n_tasks = n_tasks;
+    pool->next = 0;
+    pool->n_done = 0;
+    pthread_cond_broadcast(&pool->work);
+
+    // Help with the tasks, and then wait for the workers to finish the ones they took.
+    run_tasks(pool);
+
+    while (pool->n_done < pool->n_tasks) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->run_lock);
+}
+
+// This is a function to stop the threads and free the pool.
+void threadpool_destroy(threadpool_t *pool) {
+
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->n_workers; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run_lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool);
+}
+
+// This is the pool shared by the whole program, and the guard that creates it once.
+static threadpool_t *shared_pool = NULL;
+static pthread_once_t shared_once = PTHREAD_ONCE_INIT;
+
+// This is a function to create the shared pool.
+static void create_shared(void) {
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (n_cpus > 1) {
+        shared_pool = threadpool_create((size_t) n_cpus - 1);
+    }
+}
+
+// This is a function to get the shared pool.
+threadpool_t *threadpool_shared(void) {
+    pthread_once(&shared_once, create_shared);
+    return shared_pool;
+}
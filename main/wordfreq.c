@@ -0,0 +1,422 @@
+#include "wordfreq.h"
+#include "common.h"
+#include "list.h"
+#include "ilist.h"
+#include "outbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// This is a function to hash a word of the given length, using 32 bit FNV-1a.
+uint32_t word_hash(const char *word, size_t len) {
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char) word[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+// This is a function to create a new word-frequency pair.
+word_freq_t *word_freq_create(const char *word, size_t len, size_t count) {
+    return word_freq_create_sized(word, len, count, sizeof(word_freq_t));
+}
+
+// This is a function to create a new word-frequency pair at the start of an allocation of 'size' bytes.
+word_freq_t *word_freq_create_sized(const char *word, size_t len, size_t count, size_t size) {
+
+    // The length is cached as 32 bits, no token gets anywhere near that long.
+    if (len > UINT32_MAX || size < sizeof(word_freq_t)) {
+        return NULL;
+    }
+
+    word_freq_t *freq = malloc(size);
+    if (freq == NULL) {
+        return NULL;
+    }
+
+    freq->count = count;
+    freq->len = (uint32_t) len;
+    freq->hash = word_hash(word, len);
+
+    // Short words are copied into the record, only long words need their own allocation.
+    char *dst = freq->word.short_;
+    if (len >= WORD_FREQ_INLINE) {
+        dst = freq->word.long_ = malloc(len + 1);
+
+        if (dst == NULL) {
+            free(freq);
+            return NULL;
+        }
+    }
+
+    memcpy(dst, word, len);
+    dst[len] = 0;
+
+    return freq;
+}
+
+// This is a function to check if the word of a pair is equal to the given word.
+int word_freq_equals(const word_freq_t *freq, const char *word, size_t len, uint32_t hash) {
+    return freq->hash == hash && freq->len == len && memcmp(word_freq_word(freq), word, len) == 0;
+}
+
+// Free the 'word_freq_t', deallocate its memory.
+void word_freq_free(ilink_t *link) {
+    word_freq_t *freq = ilist_entry(link, word_freq_t, link);
+
+    if (freq->len >= WORD_FREQ_INLINE) {
+        free(freq->word.long_);
+    }
+    free(freq);
+}
+
+// This is a function to sort the 'word_freq_t' by count.
+int compare_word_freq_by_count(const ilink_t *la, const ilink_t *lb) {
+
+    const word_freq_t *a = ilist_entry(la, word_freq_t, link);
+    const word_freq_t *b = ilist_entry(lb, word_freq_t, link);
+
+    // If the counter to 'a' is larger than the counter to 'b', return -1.
+    if (a->count > b->count) {
+        return -1;
+    }
+
+    // If the counter to 'a' is smaller than the counter to 'b', return 1.
+    if (a->count < b->count) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// This is a function to sort the 'word_freq_t' by word.
+int compare_word_freq_by_word(const ilink_t *la, const ilink_t *lb) {
+
+    const word_freq_t *a = ilist_entry(la, word_freq_t, link);
+    const word_freq_t *b = ilist_entry(lb, word_freq_t, link);
+
+    // Compare the common prefix, and if that is equal the shorter word goes first.
+    size_t len = a->len < b->len ? a->len : b->len;
+    int rv = memcmp(word_freq_word(a), word_freq_word(b), len);
+
+    if (rv != 0) {
+        return rv;
+    }
+    return (a->len > b->len) - (a->len < b->len);
+}
+
+// This is the sort key for the 'word_freq_t', so that sorting by ascending key ranks the highest counts first.
+size_t word_freq_count_key(const ilink_t *link) {
+    const word_freq_t *freq = ilist_entry(link, word_freq_t, link);
+    return SIZE_MAX - freq->count;
+}
+
+// This is a struct for the pairs counted from one segment of the sorted words, see 'create_wordfreqs_list'.
+typedef struct count_acc {
+    ilist_t freqs; // These are the pairs of the segment, in the order of the sorted words.
+    int failed; // This is set if a pair could not be allocated.
+} count_acc_t;
+
+// This is a function to count a word into the pairs of a segment.
+static void count_fold(void *ctx, void *acc, void *item) {
+    count_acc_t *counts = acc;
+    char *word = item;
+    (void) ctx;
+
+    if (counts->failed) {
+        return;
+    }
+
+    size_t len = strlen(word);
+    word_freq_t *freq = counts->freqs.tail ? ilist_entry(counts->freqs.tail, word_freq_t, link) : NULL;
+
+    // If the last pair matches the current word:
+    // (The words are sorted, so only the length and the characters have to be compared, not the hash.)
+    if (freq && freq->len == len && memcmp(word_freq_word(freq), word, len) == 0) {
+        freq->count++; // Increment the count of that word.
+        return;
+    }
+
+    // Create a new word-frequency pair, with a count of 1 because its the first time the word appears.
+    freq = word_freq_create(word, len, 1);
+    if (freq == NULL) {
+        counts->failed = 1;
+        return;
+    }
+
+    // Add the newly created word-frequency pair last, so the pairs stay in the order of the sorted words.
+    ilist_addlast(&counts->freqs, &freq->link);
+}
+
+// This is a function to add the pairs of the next segment to the pairs of a segment.
+static void count_combine(void *ctx, void *acc, void *other) {
+    count_acc_t *counts = acc;
+    count_acc_t *next = other;
+    (void) ctx;
+
+    counts->failed |= next->failed;
+
+    // A word can be split between the two segments, then the first pair of the next segment is merged into the last pair.
+    if (counts->freqs.tail && next->freqs.head) {
+        word_freq_t *last = ilist_entry(counts->freqs.tail, word_freq_t, link);
+        word_freq_t *first = ilist_entry(next->freqs.head, word_freq_t, link);
+
+        if (word_freq_equals(last, word_freq_word(first), first->len, first->hash)) {
+            last->count += first->count;
+            word_freq_free(ilist_popfirst(&next->freqs));
+        }
+    }
+
+    ilist_concat(&counts->freqs, &next->freqs);
+}
+
+// This is where the 'freqs' list is filled with word-frequency pairs, counted from the sorted 'words' list.
+int create_wordfreqs_list(list_t *words, ilist_t *freqs) {
+
+    // Count the words in segments, and join the segments in the order of the words. (See 'list_reduce'.)
+    count_acc_t counts;
+    ilist_init(&counts.freqs);
+    counts.failed = 0;
+
+    list_reduce(words, &counts, sizeof(count_acc_t), count_fold, count_combine, NULL);
+
+    *freqs = counts.freqs;
+
+    if (counts.failed) {
+        printf("Error: Cannot allocate memory for a new word-frequency pair. \n");
+        goto err_cleanup;
+    }
+
+    // Sort the list by count. The sort is stable, so words with the same count stay in alphabetical order.
+    if (ilist_sort_by_key(freqs, word_freq_count_key) < 0) {
+        printf("Error: Failed to allocate memory for sorting the frequency pairs. \n");
+        goto err_cleanup;
+    }
+
+    return 0;
+
+// This is a cleanup function that will handle memory deallocation. (This is where almost every 'if-statement' goes to.)
+err_cleanup:
+
+    // Free every pair that was added to the list.
+    ilist_destroy(freqs, word_freq_free);
+
+    return -1;
+}
+
+// This is a function to get the format with the given name.
+int parse_output_format(const char *name, output_format_t *format) {
+
+    static const char *names[] = { "text", "tsv", "csv", "json" };
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *format = (output_format_t) i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+// This is a function to write a word as a CSV field, quoted if it contains a character that needs it.
+static int write_csv_word(outbuf_t *out, const char *word, size_t len) {
+
+    // The word may not be null-terminated, so only its 'len' characters are checked.
+    size_t i = 0;
+    while (i < len && word[i] != ',' && word[i] != '"' && word[i] != '\r' && word[i] != '\n') {
+        i++;
+    }
+    if (i == len) {
+        return outbuf_write(out, word, len);
+    }
+
+    // Quote the word, and double every quote inside it.
+    outbuf_putc(out, '"');
+    for (size_t i = 0; i < len; i++) {
+        if (word[i] == '"') {
+            outbuf_putc(out, '"');
+        }
+        outbuf_putc(out, word[i]);
+    }
+    return outbuf_putc(out, '"');
+}
+
+// This is a function to write a word as a JSON string.
+static int write_json_word(outbuf_t *out, const char *word, size_t len) {
+
+    outbuf_putc(out, '"');
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char) word[i];
+
+        if (c == '"' || c == '\\') {
+            outbuf_putc(out, '\\');
+            outbuf_putc(out, (char) c);
+        }
+        else if (c < 0x20) {
+            outbuf_puts(out, "\\u00");
+            outbuf_putc(out, "0123456789abcdef"[c >> 4]);
+            outbuf_putc(out, "0123456789abcdef"[c & 15]);
+        }
+        else {
+            outbuf_putc(out, (char) c);
+        }
+    }
+
+    return outbuf_putc(out, '"');
+}
+
+// This is a function to write one result in the given format.
+static void write_wordfreq(outbuf_t *out, const char *word, size_t len, size_t count, output_format_t format) {
+
+    switch (format) {
+        case FORMAT_TEXT:
+            // The same as printf("%-30s | %zu\n"), the word is padded to 30 characters.
+            outbuf_write(out, word, len);
+            if (len < 30) {
+                outbuf_fill(out, ' ', 30 - len);
+            }
+            outbuf_write(out, " | ", 3);
+            break;
+
+        case FORMAT_TSV:
+            outbuf_write(out, word, len);
+            outbuf_putc(out, '\t');
+            break;
+
+        case FORMAT_CSV:
+            write_csv_word(out, word, len);
+            outbuf_putc(out, ',');
+            break;
+
+        case FORMAT_JSON:
+            outbuf_write(out, "{\"word\":", 8);
+            write_json_word(out, word, len);
+            outbuf_write(out, ",\"count\":", 9);
+            break;
+    }
+
+    outbuf_putu(out, count);
+
+    if (format == FORMAT_JSON) {
+        outbuf_putc(out, '}');
+    }
+    outbuf_putc(out, '\n');
+}
+
+// This is a function to print the header of the results, and start the output buffer for them.
+static int print_header(outbuf_t *out, size_t n_distinct, size_t min_wc, size_t lim_nres, output_format_t format) {
+
+    /* --- These are all of the prints required to display the results in command prompt. */
+
+    if (format == FORMAT_TEXT) {
+        printf("Number of distinct words: %zu\n\n", n_distinct);
+
+        printf("--- Words that occured at least %zu times", min_wc);
+
+        if (lim_nres) {
+            printf("Error: Limiting to max %zu results. \n", lim_nres);
+        }
+
+        printf(" ---\n");
+
+        printf("%-30s   %s\n", "TERM", "COUNT");
+    }
+    else if (format == FORMAT_TSV) {
+        printf("word\tcount\n");
+    }
+    else if (format == FORMAT_CSV) {
+        printf("word,count\n");
+    }
+
+    // The results are written straight to the file descriptor, so everything printed before them has to be written first.
+    fflush(stdout);
+
+    if (outbuf_init(out, fileno(stdout), OUTBUF_SIZE) < 0) {
+        printf("Error: Failed to allocate memory for the output buffer. \n");
+        return -1;
+    }
+
+    return 0;
+}
+
+// This is a function to start printing results one at a time, it prints the header.
+int wordfreq_printer_init(wordfreq_printer_t *printer, size_t n_distinct, size_t min_wc, size_t lim_nres, output_format_t format) {
+
+    printer->min_wc = min_wc;
+    printer->lim_nres = lim_nres;
+    printer->format = format;
+    printer->n_printed = 0;
+
+    return print_header(&printer->out, n_distinct, min_wc, lim_nres, format);
+}
+
+// This is a function to print the next ranked result.
+int wordfreq_printer_add(void *ctx, const char *word, size_t len, size_t count) {
+
+    wordfreq_printer_t *printer = ctx;
+
+    // The results are ranked, so the first one under <min_wc> ends them.
+    if (count < printer->min_wc || (printer->lim_nres && printer->n_printed >= printer->lim_nres)) {
+        return 1;
+    }
+
+    write_wordfreq(&printer->out, word, len, count, printer->format);
+    printer->n_printed++;
+
+    // Stop early if the output is gone, instead of formatting results that will never be written.
+    return printer->out.error != 0;
+}
+
+// This is a function to write out the rest of the results, and free the output buffer.
+int wordfreq_printer_finish(wordfreq_printer_t *printer) {
+
+    if (outbuf_destroy(&printer->out) < 0) {
+        fprintf(stderr, "Error: Failed to write the results: %s \n", strerror(printer->out.error));
+        return -1;
+    }
+
+    return 0;
+}
+
+// This is a function that will print out the word frequency list, shows the result.
+int print_wordfreqs_list(ilist_t *freqs, size_t n_distinct, size_t min_wc, size_t lim_nres, output_format_t format) {
+
+    wordfreq_printer_t printer;
+    if (wordfreq_printer_init(&printer, n_distinct, min_wc, lim_nres, format) < 0) {
+        return -1;
+    }
+
+    // This is a loop required to print out the results to the command prompt:
+    ilist_foreach(link, freqs) {
+        word_freq_t *freq = ilist_entry(link, word_freq_t, link);
+
+        if (wordfreq_printer_add(&printer, word_freq_word(freq), freq->len, freq->count)) {
+            break;
+        }
+    }
+
+    return wordfreq_printer_finish(&printer);
+}
+
+// This is a function that will print out ranked word-frequency pairs from an array, the same way as 'print_wordfreqs_list'.
+int print_wordfreqs_array(const word_freq_t *const *freqs, size_t n, size_t n_distinct, size_t min_wc, size_t lim_nres, output_format_t format) {
+
+    wordfreq_printer_t printer;
+    if (wordfreq_printer_init(&printer, n_distinct, min_wc, lim_nres, format) < 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (wordfreq_printer_add(&printer, word_freq_word(freqs[i]), freqs[i]->len, freqs[i]->count)) {
+            break;
+        }
+    }
+
+    return wordfreq_printer_finish(&printer);
+}
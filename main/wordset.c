@@ -0,0 +1,113 @@
+#include "wordset.h"
+#include "common.h"
+#include "futil.h"
+#include "ilist.h"
+#include "phf.h"
+#include "wordfreq.h"
+#include "wordtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+// This is a function to initialize an empty set.
+int wordset_init(wordset_t *set) {
+
+    set->builtin = NULL;
+    ilist_init(&set->words);
+    return wordtable_init(&set->table, 0);
+}
+
+// This is a function to add every word of a generated table to the set.
+void wordset_add_builtin(wordset_t *set, const phf_t *builtin) {
+    set->builtin = builtin;
+}
+
+// This is a function to add a single word to the set.
+int wordset_add(wordset_t *set, const char *word, size_t len) {
+
+    uint32_t hash = word_hash(word, len);
+
+    if (wordtable_find(&set->table, word, len, hash) != NULL) {
+        return 0;
+    }
+
+    // The words are kept as pairs, so the table of the counts can be used for them as it is. (The count is not used.)
+    word_freq_t *freq = word_freq_create(word, len, 0);
+    if (freq == NULL) {
+        return -1;
+    }
+
+    if (wordtable_insert(&set->table, freq) < 0) {
+        word_freq_free(&freq->link);
+        return -1;
+    }
+
+    ilist_addlast(&set->words, &freq->link);
+    return 0;
+}
+
+// This is a function that adds each token of a file to the set, it is the 'token_fn' for 'wordset_load'.
+static int add_token(void *ctx, const char *token, size_t len) {
+    return wordset_add(ctx, token, len);
+}
+
+// This is a function to add every word of a file to the set.
+int wordset_load(wordset_t *set, const char *path) {
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    tokenizer_t tok;
+    if (tokenizer_init(&tok, 1, isspace, isalnum, tolower, add_token, set) < 0) {
+        fclose(f);
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t linesize = 0;
+    ssize_t n;
+    int rv = 0;
+
+    // Lines that start with '#' are comments, the same as for the generated tables. (See 'gen/gen_phf.c'.)
+    while (rv >= 0 && (n = getline(&line, &linesize, f)) > 0) {
+        if (line[0] != '#') {
+            rv = tokenizer_feed(&tok, line, (size_t) n);
+        }
+    }
+
+    if (rv >= 0 && ferror(f)) {
+        rv = -1;
+    }
+    if (rv >= 0) {
+        rv = tokenizer_finish(&tok);
+    }
+
+    free(line);
+    tokenizer_destroy(&tok);
+    fclose(f);
+    return rv < 0 ? -1 : 0;
+}
+
+// This is a function to check if a word is inside the set.
+int wordset_contains(wordset_t *set, const char *word, size_t len) {
+
+    if (set->builtin && phf_contains(set->builtin, word, len)) {
+        return 1;
+    }
+
+    return set->table.length > 0 && wordtable_find(&set->table, word, len, word_hash(word, len)) != NULL;
+}
+
+// This is a token filter that keeps the tokens that are not inside the set.
+int wordset_exclude(void *ctx, const char *token, size_t len) {
+    return !wordset_contains(ctx, token, len);
+}
+
+// This is a function to free the words of the set.
+void wordset_destroy(wordset_t *set) {
+    wordtable_destroy(&set->table);
+    ilist_destroy(&set->words, word_freq_free);
+    set->builtin = NULL;
+}
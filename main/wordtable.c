@@ -0,0 +1,108 @@
+#include "wordtable.h"
+#include "wordfreq.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+// This is the smallest number of slots a table will have.
+#define MIN_CAPACITY 16
+
+// This is a function to get the smallest power of two with room for 'n' pairs, while keeping the table at most half full.
+static size_t capacity_for(size_t n) {
+    size_t capacity = MIN_CAPACITY;
+
+    while (capacity < 2 * n) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// This is a function to initialize an empty table.
+int wordtable_init(wordtable_t *table, size_t n) {
+
+    table->capacity = capacity_for(n);
+    table->length = 0;
+    table->slots = calloc(table->capacity, sizeof(word_freq_t *));
+
+    if (table->slots == NULL) {
+        return -1;
+    }
+    return 0;
+}
+
+// This is a function to free the slots of the table.
+void wordtable_destroy(wordtable_t *table) {
+    free(table->slots);
+    table->slots = NULL;
+    table->capacity = 0;
+    table->length = 0;
+}
+
+// This is a function to find the pair for a word.
+word_freq_t *wordtable_find(wordtable_t *table, const char *word, size_t len, uint32_t hash) {
+
+    size_t mask = table->capacity - 1;
+
+    // Probe from the home slot of the hash until the word or an empty slot is found.
+    for (size_t i = hash & mask; table->slots[i] != NULL; i = (i + 1) & mask) {
+        if (word_freq_equals(table->slots[i], word, len, hash)) {
+            return table->slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+// This is a function to find a pair with a match function.
+word_freq_t *wordtable_find_match(wordtable_t *table, uint32_t hash, wordtable_match_fn match, void *ctx) {
+
+    size_t mask = table->capacity - 1;
+
+    // Probe like 'wordtable_find', but only call 'match' on the pairs with the same hash.
+    for (size_t i = hash & mask; table->slots[i] != NULL; i = (i + 1) & mask) {
+        if (table->slots[i]->hash == hash && match(table->slots[i], ctx)) {
+            return table->slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+// This is a function to put a pair into the first empty slot of its probe sequence.
+static void place(word_freq_t **slots, size_t capacity, word_freq_t *freq) {
+
+    size_t mask = capacity - 1;
+    size_t i = freq->hash & mask;
+
+    while (slots[i] != NULL) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = freq;
+}
+
+// This is a function to add a pair to the table.
+int wordtable_insert(wordtable_t *table, word_freq_t *freq) {
+
+    // Double the number of slots when the table would become more than half full.
+    if (2 * (table->length + 1) > table->capacity) {
+        size_t capacity = table->capacity * 2;
+        word_freq_t **slots = calloc(capacity, sizeof(word_freq_t *));
+
+        if (slots == NULL) {
+            return -1;
+        }
+
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (table->slots[i] != NULL) {
+                place(slots, capacity, table->slots[i]);
+            }
+        }
+
+        free(table->slots);
+        table->slots = slots;
+        table->capacity = capacity;
+    }
+
+    place(table->slots, table->capacity, freq);
+    table->length++;
+    return 0;
+}
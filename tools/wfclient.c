@@ -0,0 +1,66 @@
+#include "common.h"
+#include "futil.h"
+#include "server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// This is a small client for 'wordfrequency --serve'.
+// Usage: ./wfclient <socket> [request...]
+// With a request, it is sent once and the results are printed. Without one, every line of stdin is sent as a request.
+
+int main(int argc, char **argv) {
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: ./%s <socket> [request...]\n", basename(argv[0]));
+        fprintf(stderr, "Example 1: %s /tmp/wordfrequency.sock TOP 10 \n", argv[0]);
+        fprintf(stderr, "Example 2: %s /tmp/wordfrequency.sock GET house \n", argv[0]);
+        fprintf(stderr, "Example 3: printf 'STATS\\nFILTER 100 4 25\\n' | %s /tmp/wordfrequency.sock \n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    server_conn_t *conn = server_connect(argv[1]);
+    if (conn == NULL) {
+        printf("Error: Failed to connect to %s \n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    long rv = 0;
+    char line[SERVER_MAX_LINE];
+
+    if (argc > 2) {
+
+        // Join the remaining arguments with spaces into a single request.
+        size_t len = 0;
+        line[0] = 0;
+
+        for (int i = 2; i < argc; i++) {
+            int n = snprintf(line + len, sizeof(line) - len, i > 2 ? " %s" : "%s", argv[i]);
+            if (n < 0 || (size_t) n >= sizeof(line) - len) {
+                printf("Error: The request is too long. \n");
+                server_disconnect(conn);
+                return EXIT_FAILURE;
+            }
+            len += n;
+        }
+
+        rv = server_query(conn, line, stdout);
+    }
+    else {
+        while (fgets(line, sizeof(line), stdin)) {
+            line[strcspn(line, "\r\n")] = 0;
+
+            rv = server_query(conn, line, stdout);
+            if (rv == -1) {
+                break;
+            }
+        }
+    }
+
+    if (rv == -1) {
+        printf("Error: The connection to the server failed. \n");
+    }
+
+    server_disconnect(conn);
+    return rv < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
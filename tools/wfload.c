@@ -0,0 +1,144 @@
+#include "common.h"
+#include "futil.h"
+#include "server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+// This is a load test for 'wordfrequency --serve'.
+// Usage: ./wfload <socket> <n_clients> <n_requests> [request...]
+// Every client connects once and sends <n_requests> requests, one at a time, cycling through the given requests.
+// The throughput and the latency percentiles of all requests are printed at the end.
+
+// This is a struct for the work and the results of one client thread.
+typedef struct worker {
+    pthread_t thread;
+    const char *sockpath; // This is the path of the server socket.
+    char **requests; // These are the requests to cycle through.
+    int n_kinds; // This is how many different requests there are.
+    size_t n_requests; // This is how many requests to send.
+    double *latency; // This is the latency of each request, in seconds.
+    size_t n_lines; // This is the total number of result lines received, to check that the server answered.
+    int failed; // This is set if the connection or a request failed.
+} worker_t;
+
+// This is a function to get the current time in seconds.
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// This is the function that every client thread runs.
+static void *run_worker(void *arg) {
+    worker_t *w = arg;
+
+    server_conn_t *conn = server_connect(w->sockpath);
+    if (conn == NULL) {
+        w->failed = 1;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < w->n_requests; i++) {
+        double t0 = now();
+        long rv = server_query(conn, w->requests[i % w->n_kinds], NULL);
+        w->latency[i] = now() - t0;
+
+        if (rv < 0) {
+            w->failed = 1;
+            break;
+        }
+        w->n_lines += rv;
+    }
+
+    server_disconnect(conn);
+    return NULL;
+}
+
+// This is a comparison function for sorting the latencies.
+static int doublecmp(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+
+    if (argc < 4) {
+        fprintf(stderr, "Usage: ./%s <socket> <n_clients> <n_requests> [request...]\n", basename(argv[0]));
+        fprintf(stderr, "* <n_requests>: How many requests each client sends. \n");
+        fprintf(stderr, "* [request...]: The requests to cycle through, \"TOP 10\" if none are given. \n");
+        fprintf(stderr, "Example: %s /tmp/wordfrequency.sock 4 10000 \"TOP 10\" \"GET house\" \"FILTER 100 4 25\" \n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int n_clients = atoi(argv[2]);
+    size_t n_requests = strtoul(argv[3], NULL, 10);
+
+    if (n_clients < 1 || n_requests < 1) {
+        printf("Error: <n_clients> and <n_requests> must be at least 1. \n");
+        return EXIT_FAILURE;
+    }
+
+    char *default_request[] = { "TOP 10" };
+    char **requests = argc > 4 ? argv + 4 : default_request;
+    int n_kinds = argc > 4 ? argc - 4 : 1;
+
+    worker_t *workers = calloc(n_clients, sizeof(worker_t));
+    double *latency = malloc(n_clients * n_requests * sizeof(double));
+
+    if (workers == NULL || latency == NULL) {
+        printf("Error: Failed to allocate memory for the clients. \n");
+        free(workers);
+        free(latency);
+        return EXIT_FAILURE;
+    }
+
+    double t0 = now();
+
+    int n_started = 0;
+    for (int i = 0; i < n_clients; i++) {
+        worker_t *w = &workers[i];
+        w->sockpath = argv[1];
+        w->requests = requests;
+        w->n_kinds = n_kinds;
+        w->n_requests = n_requests;
+        w->latency = latency + i * n_requests;
+
+        if (pthread_create(&w->thread, NULL, run_worker, w) != 0) {
+            printf("Error: Failed to start client thread %d. \n", i);
+            break;
+        }
+        n_started++;
+    }
+
+    int failed = n_started < n_clients;
+    size_t n_lines = 0;
+
+    for (int i = 0; i < n_started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        failed |= workers[i].failed;
+        n_lines += workers[i].n_lines;
+    }
+
+    double elapsed = now() - t0;
+
+    if (failed) {
+        printf("Error: One or more clients failed, is the server running on %s? \n", argv[1]);
+    }
+    else {
+        size_t total = n_clients * n_requests;
+        qsort(latency, total, sizeof(double), doublecmp);
+
+        printf("Requests: %zu from %d clients in %.3f s (%zu result lines)\n", total, n_clients, elapsed, n_lines);
+        printf("Throughput: %.0f requests/s\n", total / elapsed);
+        printf("Latency (us): p50 %.1f | p90 %.1f | p99 %.1f | max %.1f\n",
+            latency[total / 2] * 1e6, latency[total * 9 / 10] * 1e6, latency[total * 99 / 100] * 1e6, latency[total - 1] * 1e6);
+    }
+
+    free(workers);
+    free(latency);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}